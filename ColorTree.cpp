@@ -20,14 +20,18 @@
 
 #include <sstream>
 #include <stack>
+#include <string>
 #include <utility>
 
 #include <curses.h>
 
+#include "utils.hpp"
+
 using namespace cursed;
 
 static int colorToInt(Color color);
-static ColorTree fromEscapeCodes(const std::wstring &line, std::size_t offset);
+template <typename S>
+static ColorTree fromEscapeCodes(const S &line, std::size_t offset);
 
 // Manages combining of multiple formats.  The idea is that formats are added to
 // the state when they become active and are removed after they become inactive.
@@ -156,6 +160,12 @@ Format::operator()(std::wstring text) const
     return ColorTree(std::move(text), *this);
 }
 
+ColorTree
+Format::operator()(std::string text) const
+{
+    return ColorTree(std::move(text), *this);
+}
+
 ColorTree
 Format::operator()(ColorTree &&tree) const
 {
@@ -189,6 +199,23 @@ cursed::operator+=(Format &lhs, const Format &rhs)
     return lhs;
 }
 
+bool
+cursed::operator==(const Format &lhs, const Format &rhs)
+{
+    return lhs.getForeground() == rhs.getForeground()
+        && lhs.getBackground() == rhs.getBackground()
+        && lhs.isBold() == rhs.isBold()
+        && lhs.isReversed() == rhs.isReversed()
+        && lhs.isUnderlined() == rhs.isUnderlined()
+        && lhs.isStandalone() == rhs.isStandalone();
+}
+
+bool
+cursed::operator!=(const Format &lhs, const Format &rhs)
+{
+    return !(lhs == rhs);
+}
+
 ColorTree::ColorTree(Format format) : format(std::move(format))
 { }
 
@@ -199,34 +226,59 @@ ColorTree::ColorTree(std::wstring text, Format format)
     : format(std::move(format)), text(std::move(text))
 { }
 
+ColorTree::ColorTree(std::string text) : text(std::move(text))
+{ }
+
+ColorTree::ColorTree(const char text[], std::size_t len)
+    : text(std::string(text, len))
+{ }
+
+ColorTree::ColorTree(std::string text, Format format)
+    : format(std::move(format)), text(std::move(text))
+{ }
+
+ColorTree::ColorTree(guts::LeafText text, Format format)
+    : format(std::move(format)), text(std::move(text))
+{ }
+
 ColorTree
 ColorTree::fromEscapeCodes(const std::wstring &line)
 {
     return ::fromEscapeCodes(line, 0);
 }
 
+ColorTree
+ColorTree::fromEscapeCodes(const std::string &line)
+{
+    return ::fromEscapeCodes(line, 0);
+}
+
 // Builds a ColorTree out of a substring of its argument starting with offset by
-// parsing escape codes.
+// parsing escape codes.  Works for both wide and UTF-8 strings.
+template <typename S>
 static ColorTree
-fromEscapeCodes(const std::wstring &line, std::size_t offset)
+fromEscapeCodes(const S &line, std::size_t offset)
 {
+    using charType = typename S::value_type;
+
     if (line.empty() || offset == line.length()) {
         return {};
     }
 
-    auto start = line.find(L'\033', offset);
-    if (start == std::wstring::npos || line[start + 1] != L'[') {
+    auto start = line.find(charType('\033'), offset);
+    if (start == S::npos || line[start + 1] != charType('[')) {
         return line.substr(offset);
     }
 
-    auto end = line.find(L'm', start + 2);
-    if (end == std::wstring::npos) {
+    auto end = line.find(charType('m'), start + 2);
+    if (end == S::npos) {
         return line.substr(offset);
     }
 
-    std::wistringstream iwss(line.substr(start + 2, end - start - 1));
+    std::basic_istringstream<charType> iwss(line.substr(start + 2,
+                                                        end - start - 1));
     int n;
-    wchar_t separator;
+    charType separator;
     cursed::Format fmt;
     while (iwss >> n >> separator) {
         if (n == 0) {
@@ -251,7 +303,7 @@ fromEscapeCodes(const std::wstring &line, std::size_t offset)
             fmt.setBackground(-1);
         } else if (n == 38) {
             int nn;
-            wchar_t ss;
+            charType ss;
             if (iwss >> nn >> ss >> n >> separator) {
                 if (nn == 5) {
                     fmt.setForeground(n);
@@ -259,7 +311,7 @@ fromEscapeCodes(const std::wstring &line, std::size_t offset)
             }
         } else if (n == 48) {
             int nn;
-            wchar_t ss;
+            charType ss;
             if (iwss >> nn >> ss >> n >> separator) {
                 if (nn == 5) {
                     fmt.setBackground(n);
@@ -267,7 +319,7 @@ fromEscapeCodes(const std::wstring &line, std::size_t offset)
             }
         }
 
-        if (separator == L'm') {
+        if (separator == charType('m')) {
             return line.substr(offset, start - offset)
                  + fmt(fromEscapeCodes(line, end + 1));
         }
@@ -281,36 +333,64 @@ ColorTree::append(ColorTree &&branch)
 {
     if (!text.empty()) {
         // A child is being added to a leaf, turn contents into a child first.
-        branches.emplace_back(std::move(text), format);
-        text = std::wstring();
+        branches.push_back(ColorTree(std::move(text), format));
+        text = guts::LeafText();
         format = Format();
     }
     branches.emplace_back(std::move(branch));
 }
 
 void
-ColorTree::visit(const visitorFunc &visitor) const
+ColorTree::visit(const visitorFunc &visitor, const Format &base) const
+{
+    visitRaw([&visitor](const guts::LeafText &text, const Format &format) {
+        if (text.isUtf8()) {
+            visitor(text.toWide(), format);
+        } else {
+            visitor(text.getWide(), format);
+        }
+    }, base);
+}
+
+void
+ColorTree::visitRaw(const rawVisitorFunc &visitor, const Format &base) const
+{
+    visitRawWhile([&visitor](const guts::LeafText &text, const Format &format) {
+        visitor(text, format);
+        return true;
+    }, base);
+}
+
+void
+ColorTree::visitRawWhile(const rawPredicateFunc &visitor,
+                         const Format &base) const
 {
     struct {
-        const visitorFunc &visitor;
+        const rawPredicateFunc &visitor;
         FormatState formatState;
 
-        void visit(const ColorTree &tree)
+        bool visit(const ColorTree &tree)
         {
             formatState += tree.format;
 
             if (tree.branches.empty()) {
-                visitor(tree.text, formatState.getCurrent());
+                if (!visitor(tree.text, formatState.getCurrent())) {
+                    return false;
+                }
             } else {
                 for (const ColorTree &branch : tree.branches) {
-                    visit(branch);
+                    if (!visit(branch)) {
+                        return false;
+                    }
                 }
             }
 
             formatState -= tree.format;
+            return true;
         }
     } f = { visitor, {} };
 
+    f.formatState += base;
     f.visit(*this);
 }
 
@@ -339,6 +419,20 @@ ColorTree::length() const
     return len;
 }
 
+std::string
+ColorTree::toUtf8() const
+{
+    std::string utf8;
+    visitRaw([&utf8](const guts::LeafText &text, const Format &/*format*/) {
+        if (text.isUtf8()) {
+            utf8 += text.getUtf8();
+        } else {
+            utf8 += cursed::toUtf8(text.getWide());
+        }
+    });
+    return utf8;
+}
+
 ColorTree
 cursed::operator+(ColorTree &&lhs, ColorTree &&rhs)
 {
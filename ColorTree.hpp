@@ -19,11 +19,15 @@
 #ifndef LIBCURSED__COLORTREE_HPP__
 #define LIBCURSED__COLORTREE_HPP__
 
+#include <cstddef>
+
 #include <array>
 #include <functional>
 #include <string>
 #include <vector>
 
+#include "guts/LeafText.hpp"
+
 // Usage example:
 //
 //     cursed::Format fmt;
@@ -110,6 +114,8 @@ public:
     ColorTree operator()(const wchar_t (&text)[N]);
     // Applies this formatting to specified piece of text.
     ColorTree operator()(std::wstring text) const;
+    // Applies this formatting to specified piece of UTF-8 text.
+    ColorTree operator()(std::string text) const;
     // Applies this formatting to a tree.
     ColorTree operator()(ColorTree &&tree) const;
 
@@ -125,6 +131,11 @@ private:
 // Mixes one format with another.
 Format & operator+=(Format &lhs, const Format &rhs);
 
+// Checks whether two formats are identical.
+bool operator==(const Format &lhs, const Format &rhs);
+// Checks whether two formats differ.
+bool operator!=(const Format &lhs, const Format &rhs);
+
 // Describes hierarchically colourable piece of text.
 class ColorTree
 {
@@ -133,6 +144,13 @@ class ColorTree
     // Type of callback function invoked for leaf nodes on visit.
     using visitorFunc = std::function<void(const std::wstring &text,
                                            const Format &format)>;
+    // Type of callback function invoked for leaf nodes on raw visit.
+    using rawVisitorFunc = std::function<void(const guts::LeafText &text,
+                                              const Format &format)>;
+    // Type of callback function invoked for leaf nodes on raw visit which
+    // returns `false` to stop the visit.
+    using rawPredicateFunc = std::function<bool(const guts::LeafText &text,
+                                                const Format &format)>;
 
 public:
     // Constructs an empty tree.
@@ -143,35 +161,61 @@ public:
     ColorTree(std::wstring text);
     // Constructs a leaf node with text specified as a literal.
     template <std::size_t N>
-    ColorTree(const wchar_t (&text)[N]) : text(text, text + N - 1)
+    ColorTree(const wchar_t (&text)[N])
+        : text(std::wstring(text, text + N - 1))
     { }
     // Constructs a leaf node with text specified as `wchar_t` array.
-    ColorTree(const wchar_t text[]) : text(text)
+    ColorTree(const wchar_t text[]) : text(std::wstring(text))
     { }
     // Constructs a leaf node from text specified as `std::array<wchar_t, N>`.
     template <std::size_t N>
-    ColorTree(const std::array<wchar_t, N> &text) : text(text.data())
+    ColorTree(const std::array<wchar_t, N> &text)
+        : text(std::wstring(text.data()))
     { }
     // Constructs a leaf node with specified text and format.
     ColorTree(std::wstring text, Format format);
+    // Constructs a leaf node with UTF-8 text and empty format.  The text is
+    // stored as is, which takes up less memory for mostly ASCII text.
+    ColorTree(std::string text);
+    // Constructs a leaf node with UTF-8 text specified as a span of bytes.
+    ColorTree(const char text[], std::size_t len);
+    // Constructs a leaf node with specified UTF-8 text and format.
+    ColorTree(std::string text, Format format);
 
 public:
     // Builds an instance out of a string with escape codes.
     static ColorTree fromEscapeCodes(const std::wstring &line);
+    // Builds an instance out of a UTF-8 string with escape codes.  Text of the
+    // tree is stored in UTF-8.
+    static ColorTree fromEscapeCodes(const std::string &line);
 
 public:
     // Extends tree by appending another branch to it.
     void append(ColorTree &&branch);
 
-    // Invokes visitor per leaf node of the tree.
-    void visit(const visitorFunc &visitor) const;
+    // Invokes visitor per leaf node of the tree.  `base` is merged in as if
+    // the tree was wrapped into it, but without building a new tree.
+    void visit(const visitorFunc &visitor, const Format &base = {}) const;
+    // Same as `visit()`, but passes text of leafs as stored without converting
+    // it to wide strings.
+    void visitRaw(const rawVisitorFunc &visitor, const Format &base = {}) const;
+    // Same as `visitRaw()`, but stops traversal as soon as visitor returns
+    // `false`.
+    void visitRawWhile(const rawPredicateFunc &visitor,
+                       const Format &base = {}) const;
 
     // Retrieves cumulative length of all pieces of the tree.
     int length() const;
+    // Retrieves text of the tree without formatting in UTF-8.
+    std::string toUtf8() const;
+
+private:
+    // Constructs a leaf node with specified text and format.
+    ColorTree(guts::LeafText text, Format format);
 
 private:
     Format format;                   // Format of the tree.
-    std::wstring text;               // Text of a leaf.
+    guts::LeafText text;             // Text of a leaf.
     std::vector<ColorTree> branches; // Child trees.
 };
 
@@ -0,0 +1,406 @@
+// libcursed -- C++ classes for dealing with curses
+// Copyright (C) 2022 xaizek <xaizek@posteo.net>
+//
+// This file is part of libcursed.
+//
+// libcursed is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// libcursed is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with libcursed.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "FileSource.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace cursed;
+
+// Size of a piece of file that's indexed before publishing its lines.
+constexpr std::size_t IndexChunkSize = 4*1024*1024;
+// Number of offsets of ends of lines in a chunk of storage.
+constexpr std::size_t EndsChunkSize = 64*1024;
+
+namespace {
+
+// Header of index file.  It's followed by an array of `count` 64-bit offsets
+// of newline characters in native byte order.
+struct IndexHeader
+{
+    char magic[8];          // File format marker and version.
+    std::uint64_t size;     // Size of indexed file.
+    std::int64_t mtimeSec;  // Modification time of indexed file (seconds).
+    std::int64_t mtimeNsec; // Modification time of indexed file (nanoseconds).
+    std::uint64_t count;    // Number of offsets that follow.
+};
+
+}
+
+static bool checkOffsets(const std::uint64_t offsets[], std::uint64_t count,
+                         std::uint64_t limit, const char data[]);
+
+// Identifies index file of current version.
+static const char IndexMagic[8] = { 'c', 'u', 'r', 's', 'i', 'd', 'x', '1' };
+
+// Number of offsets of a loaded index that are checked on loading it.
+constexpr std::uint64_t IndexSamples = 64U;
+
+FileSource::FileSource(const std::string &path, const std::string &indexPath)
+    : data(nullptr), size(0U), mtimeSec(0), mtimeNsec(0), indexPath(indexPath),
+      indexMap(nullptr), indexMapSize(0U), indexUpToDate(false),
+      savedEnds(nullptr), nSaved(0U), nEnds(0U), corruptIndex(false),
+      indexed(false), stop(false)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd == -1) {
+        throw std::runtime_error("Failed to open file: " + path);
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        throw std::runtime_error("Failed to query file: " + path);
+    }
+    size = st.st_size;
+    mtimeSec = st.st_mtim.tv_sec;
+    mtimeNsec = st.st_mtim.tv_nsec;
+
+    if (size != 0U) {
+        void *ptr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (ptr == MAP_FAILED) {
+            close(fd);
+            throw std::runtime_error("Failed to map file: " + path);
+        }
+        data = static_cast<const char *>(ptr);
+        (void)madvise(ptr, size, MADV_SEQUENTIAL);
+    }
+    close(fd);
+
+    std::size_t offset = loadIndex();
+
+    // Every byte can end a line plus there can be an unterminated last line.
+    const std::size_t maxEnds = size - offset + 1U;
+    ends.reset(new std::unique_ptr<std::uint64_t[]>[
+        (maxEnds + EndsChunkSize - 1U)/EndsChunkSize
+    ]);
+
+    indexer = std::thread(&FileSource::buildIndex, this, offset);
+}
+
+FileSource::~FileSource()
+{
+    stop = true;
+    if (indexer.joinable()) {
+        indexer.join();
+    }
+
+    if (data != nullptr) {
+        munmap(const_cast<char *>(data), size);
+    }
+    if (indexMap != nullptr) {
+        munmap(indexMap, indexMapSize);
+    }
+
+    // Damaged index file is dropped to be rebuilt on next opening.
+    if (corruptIndex) {
+        unlink(indexPath.c_str());
+    }
+}
+
+int
+FileSource::getLineCount()
+{
+    return nSaved + nEnds.load(std::memory_order_acquire);
+}
+
+ColorTree
+FileSource::getLine(int i)
+{
+    std::uint64_t start, end;
+    if (!getBounds(i, start, end)) {
+        return {};
+    }
+
+    if (end > start && data[end - 1] == '\r') {
+        --end;
+    }
+
+    return ColorTree::fromEscapeCodes(std::string(data + start, end - start));
+}
+
+std::string
+FileSource::getPlainLine(int i)
+{
+    std::uint64_t start, end;
+    if (!getBounds(i, start, end)) {
+        return {};
+    }
+
+    // Most lines lack escape sequences and need no parsing.
+    if (std::memchr(data + start, '\033', end - start) != nullptr) {
+        return getLine(i).toUtf8();
+    }
+
+    if (end > start && data[end - 1] == '\r') {
+        --end;
+    }
+    return std::string(data + start, end - start);
+}
+
+bool
+FileSource::isIndexed() const
+{
+    return indexed;
+}
+
+void
+FileSource::waitForIndex()
+{
+    if (indexer.joinable()) {
+        indexer.join();
+    }
+}
+
+std::size_t
+FileSource::loadIndex()
+{
+    if (indexPath.empty()) {
+        return 0U;
+    }
+
+    int fd = open(indexPath.c_str(), O_RDONLY);
+    if (fd == -1) {
+        return 0U;
+    }
+
+    struct stat st;
+    void *ptr = MAP_FAILED;
+    if (fstat(fd, &st) == 0 &&
+        static_cast<std::size_t>(st.st_size) >= sizeof(IndexHeader)) {
+        ptr = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);
+
+    if (ptr == MAP_FAILED) {
+        return 0U;
+    }
+
+    const std::size_t mapSize = st.st_size;
+    const IndexHeader *header = static_cast<const IndexHeader *>(ptr);
+    const std::uint64_t *offsets =
+        reinterpret_cast<const std::uint64_t *>(header + 1);
+    const std::uint64_t count = header->count;
+
+    bool valid =
+        std::memcmp(header->magic, IndexMagic, sizeof(IndexMagic)) == 0 &&
+        count <= (mapSize - sizeof(IndexHeader))/sizeof(std::uint64_t) &&
+        mapSize == sizeof(IndexHeader) + count*sizeof(std::uint64_t);
+
+    bool unchanged = valid && header->size == size &&
+                     header->mtimeSec == mtimeSec &&
+                     header->mtimeNsec == mtimeNsec;
+
+    // A file that has grown is assumed to be appended to, which is checked
+    // along with the offsets below.
+    bool grown = valid && !unchanged && header->size < size;
+
+    if ((!unchanged && !grown) ||
+        !checkOffsets(offsets, count, header->size, data)) {
+        munmap(ptr, mapSize);
+        return 0U;
+    }
+
+    indexMap = ptr;
+    indexMapSize = mapSize;
+    indexUpToDate = unchanged;
+    savedEnds = offsets;
+    nSaved = count;
+    return (count == 0U ? 0U : offsets[count - 1U] + 1U);
+}
+
+void
+FileSource::buildIndex(std::size_t offset)
+{
+    std::vector<std::uint64_t> found;
+    while (offset < size && !stop) {
+        const std::size_t chunkEnd = std::min(size, offset + IndexChunkSize);
+
+        found.clear();
+        const char *p = data + offset;
+        const char *const e = data + chunkEnd;
+        while (const void *nl = std::memchr(p, '\n', e - p)) {
+            found.push_back(static_cast<const char *>(nl) - data);
+            p = static_cast<const char *>(nl) + 1;
+        }
+
+        addEnds(found);
+
+        offset = chunkEnd;
+    }
+
+    if (stop) {
+        return;
+    }
+
+    // Index file lists only newlines, so it's saved before adding the end of
+    // the last line.
+    if (!indexPath.empty() && !indexUpToDate) {
+        saveIndex();
+    }
+
+    // The last line might lack trailing newline.
+    if (size != 0U && data[size - 1U] != '\n') {
+        addEnds({ size });
+    }
+
+    indexed = true;
+}
+
+void
+FileSource::saveIndex()
+{
+    IndexHeader header;
+    std::memcpy(header.magic, IndexMagic, sizeof(IndexMagic));
+    header.size = size;
+    header.mtimeSec = mtimeSec;
+    header.mtimeNsec = mtimeNsec;
+    header.count = nSaved + nEnds;
+
+    // Index file might be mapped at the moment, so new one is written next to
+    // it under a unique name and then replaces it.
+    std::string tmpPath = indexPath + ".XXXXXX";
+    int fd = mkstemp(&tmpPath[0]);
+    if (fd == -1) {
+        return;
+    }
+
+    // Writes a buffer retrying on partial writes.
+    auto writeAll = [fd](const void *buf, std::size_t len) {
+        const char *p = static_cast<const char *>(buf);
+        while (len != 0U) {
+            ssize_t n = write(fd, p, len);
+            if (n <= 0) {
+                return false;
+            }
+            p += n;
+            len -= n;
+        }
+        return true;
+    };
+
+    bool ok = writeAll(&header, sizeof(header)) &&
+              writeAll(savedEnds, nSaved*sizeof(std::uint64_t));
+    for (std::size_t i = 0U; ok && i < nEnds; i += EndsChunkSize) {
+        const std::size_t n = std::min<std::size_t>(EndsChunkSize, nEnds - i);
+        ok = writeAll(ends[i/EndsChunkSize].get(), n*sizeof(std::uint64_t));
+    }
+    // Contents must reach the disk before the rename, otherwise a crash can
+    // leave an empty or partial index under the final name.
+    ok = ok && fchmod(fd, 0644) == 0 && fsync(fd) == 0;
+    ok = (close(fd) == 0) && ok;
+
+    if (!ok || rename(tmpPath.c_str(), indexPath.c_str()) != 0) {
+        unlink(tmpPath.c_str());
+    }
+}
+
+std::uint64_t
+FileSource::getEnd(int i) const
+{
+    const std::size_t idx = i;
+    if (idx < nSaved) {
+        return savedEnds[idx];
+    }
+    const std::size_t j = idx - nSaved;
+    return ends[j/EndsChunkSize][j%EndsChunkSize];
+}
+
+void
+FileSource::addEnds(const std::vector<std::uint64_t> &found)
+{
+    std::size_t n = nEnds.load(std::memory_order_relaxed);
+    std::size_t copied = 0U;
+    while (copied != found.size()) {
+        std::unique_ptr<std::uint64_t[]> &chunk = ends[n/EndsChunkSize];
+        if (chunk == nullptr) {
+            chunk.reset(new std::uint64_t[EndsChunkSize]);
+        }
+
+        const std::size_t count = std::min(found.size() - copied,
+                                           EndsChunkSize - n%EndsChunkSize);
+        std::copy_n(found.cbegin() + copied, count,
+                    chunk.get() + n%EndsChunkSize);
+        copied += count;
+        n += count;
+    }
+
+    // Elements are written before they are published.
+    nEnds.store(n, std::memory_order_release);
+}
+
+bool
+FileSource::getBounds(int i, std::uint64_t &start, std::uint64_t &end)
+{
+    start = (i == 0 ? 0U : getEnd(i - 1) + 1U);
+    end = getEnd(i);
+
+    // Only a sample of a loaded index is checked on opening, so the rest of
+    // it is validated here as lines are requested.  A line must end at a
+    // newline (or end of file) and contain no other newlines.
+    if (start > end || end > size || (end != size && data[end] != '\n') ||
+        std::memchr(data + start, '\n', end - start) != nullptr) {
+        corruptIndex = true;
+        return false;
+    }
+    return true;
+}
+
+// Checks a sample of offsets of a loaded index along with the last one: they
+// should be increasing, be below `limit` and point at newlines.  The rest of
+// offsets is checked lazily on use to avoid reading the whole index and file.
+static bool
+checkOffsets(const std::uint64_t offsets[], std::uint64_t count,
+             std::uint64_t limit, const char data[])
+{
+    if (count == 0U) {
+        return true;
+    }
+
+    const std::uint64_t last = count - 1U;
+    const std::uint64_t step = std::max<std::uint64_t>(1U,
+                                                       count/IndexSamples);
+    std::uint64_t prev = 0U;
+    for (std::uint64_t i = 0U; ; i = std::min(i + step, last)) {
+        if (offsets[i] >= limit || data[offsets[i]] != '\n') {
+            return false;
+        }
+        if (i != 0U && offsets[i] <= offsets[prev]) {
+            return false;
+        }
+        if (i == last) {
+            break;
+        }
+        prev = i;
+    }
+    return true;
+}
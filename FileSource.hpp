@@ -0,0 +1,116 @@
+// libcursed -- C++ classes for dealing with curses
+// Copyright (C) 2022 xaizek <xaizek@posteo.net>
+//
+// This file is part of libcursed.
+//
+// libcursed is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// libcursed is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with libcursed.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef LIBCURSED__FILESOURCE_HPP__
+#define LIBCURSED__FILESOURCE_HPP__
+
+#include <cstddef>
+#include <cstdint>
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ColorTree.hpp"
+#include "TextSource.hpp"
+
+namespace cursed {
+
+// Source of lines of a UTF-8 file with escape codes for `Text` widget.  The
+// file is mapped into memory and index of lines is built in background, lines
+// become available as they are indexed.  Only offsets of lines are kept in
+// memory, lines are parsed when requested.
+//
+// The index can be stored in a separate file to be reused on next opening of
+// the same file.  The stored index is used if size and modification time of
+// the file didn't change, it's extended if the file has grown and is rebuilt
+// otherwise.  Offsets of stored index are checked as lines are retrieved, lines
+// affected by a damaged index are empty and the index file is removed on
+// destruction.
+class FileSource : public TextSource
+{
+public:
+    // Maps the file and starts indexing it.  Non-empty `indexPath` specifies
+    // where index is loaded from and saved to.  Throws `std::runtime_error` on
+    // failure to map the file, problems with index file are ignored.
+    explicit FileSource(const std::string &path,
+                        const std::string &indexPath = {});
+    // Stops indexing and unmaps the file.
+    ~FileSource();
+
+    FileSource(const FileSource &rhs) = delete;
+    FileSource(FileSource &&rhs) = delete;
+    FileSource & operator=(const FileSource &rhs) = delete;
+    FileSource & operator=(FileSource &&rhs) = delete;
+
+public:
+    // Retrieves number of lines that are indexed so far.
+    virtual int getLineCount() override;
+    // Retrieves line by its index (should be a valid one).
+    virtual ColorTree getLine(int i) override;
+    // Retrieves text of a line without escape sequences.
+    virtual std::string getPlainLine(int i) override;
+
+    // Checks whether the whole file has been indexed.
+    bool isIndexed() const;
+    // Blocks until the whole file is indexed.
+    void waitForIndex();
+
+private:
+    // Maps stored index if it's usable.  Returns offset at which indexing of
+    // the file should start.
+    std::size_t loadIndex();
+    // Builds index of lines.
+    void buildIndex(std::size_t offset);
+    // Writes index to the index file.
+    void saveIndex();
+    // Retrieves end of a line (index must be valid).
+    std::uint64_t getEnd(int i) const;
+    // Stores ends of lines and makes them available to readers.
+    void addEnds(const std::vector<std::uint64_t> &found);
+    // Retrieves bounds of a line (index must be valid).  Returns `false` if
+    // loaded index turns out to be corrupted.
+    bool getBounds(int i, std::uint64_t &start, std::uint64_t &end);
+
+private:
+    const char *data;                // Contents of the file.
+    std::size_t size;                // Size of the file.
+    std::int64_t mtimeSec;           // Modification time of the file (sec).
+    std::int64_t mtimeNsec;          // Modification time of the file (nsec).
+    std::string indexPath;           // Path to index file or empty string.
+    void *indexMap;                  // Mapped index file or `nullptr`.
+    std::size_t indexMapSize;        // Size of mapped index file.
+    bool indexUpToDate;              // Whether index file needs no updates.
+    const std::uint64_t *savedEnds;  // Offsets of ends of lines from index.
+    std::size_t nSaved;              // Number of elements in `savedEnds`.
+    // Offsets of ends of following lines in chunks.  Table of chunks is
+    // allocated upfront, so stored elements never move and can be read
+    // without locking.
+    std::unique_ptr<std::unique_ptr<std::uint64_t[]>[]> ends;
+    std::atomic<std::size_t> nEnds;  // Number of published elements of `ends`.
+    std::atomic<bool> corruptIndex;  // Whether loaded index is corrupted.
+    std::atomic<bool> indexed;       // Whether index is complete.
+    std::atomic<bool> stop;          // Request to stop indexing.
+    std::thread indexer;             // Thread that builds index.
+};
+
+}
+
+#endif // LIBCURSED__FILESOURCE_HPP__
@@ -0,0 +1,264 @@
+// libcursed -- C++ classes for dealing with curses
+// Copyright (C) 2022 xaizek <xaizek@posteo.net>
+//
+// This file is part of libcursed.
+//
+// libcursed is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// libcursed is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with libcursed.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "Grid.hpp"
+
+#include <cstdlib>
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#include "guts/Layout.hpp"
+#include "guts/Pos.hpp"
+#include "guts/Size.hpp"
+
+using namespace cursed;
+using namespace cursed::guts;
+
+static int combinePolicies(int a, int b);
+static void computeOffsets(const std::vector<int> &lengths,
+                           std::vector<int> &offsets);
+
+// Size policy of a row or a column that has no widgets.
+static const int unset = std::numeric_limits<int>::max();
+
+Grid::Grid(int rows, int cols)
+{
+    if (rows < 0 || cols < 0) {
+        throw std::invalid_argument("Grid dimensions can't be negative");
+    }
+
+    rowFlexes.assign(rows, Flex(0));
+    colFlexes.assign(cols, Flex(0));
+}
+
+void
+Grid::addItem(Widget *w, int row, int col, int rowSpan, int colSpan)
+{
+    const int nRows = rowFlexes.size();
+    const int nCols = colFlexes.size();
+    if (row < 0 || col < 0 || rowSpan < 1 || colSpan < 1 ||
+        row + rowSpan > nRows || col + colSpan > nCols) {
+        throw std::invalid_argument("Grid item is out of bounds");
+    }
+
+    items.push_back({ w, row, col, rowSpan, colSpan });
+    w->setParent(this);
+    invalidateSize();
+}
+
+void
+Grid::setRowFlex(int row, Flex flex)
+{
+    rowFlexes[row] = flex;
+    invalidateSize();
+}
+
+void
+Grid::setColumnFlex(int col, Flex flex)
+{
+    colFlexes[col] = flex;
+    invalidateSize();
+}
+
+void
+Grid::placed(Pos newPos, Size newSize)
+{
+    computePolicies(true);
+    doLayout(lengths, rowFlexes, newSize.lines, heights);
+    computeOffsets(heights, rowOffsets);
+
+    computePolicies(false);
+    doLayout(lengths, colFlexes, newSize.cols, widths);
+    computeOffsets(widths, colOffsets);
+
+    for (const Item &item : items) {
+        const int top = rowOffsets[item.row];
+        const int left = colOffsets[item.col];
+        const int bottom = rowOffsets[item.row + item.rowSpan];
+        const int right = colOffsets[item.col + item.colSpan];
+        item.widget->place(Pos(newPos.x + left, newPos.y + top),
+                           Size(bottom - top, right - left));
+    }
+}
+
+void
+Grid::draw()
+{
+    for (const Item &item : items) {
+        if (!item.widget->isHidden()) {
+            item.widget->draw();
+        }
+    }
+}
+
+int
+Grid::desiredHeight()
+{
+    return computeDesired(true);
+}
+
+int
+Grid::desiredWidth()
+{
+    return computeDesired(false);
+}
+
+void
+Grid::computePolicies(bool rows)
+{
+    const std::vector<Flex> &flexes = (rows ? rowFlexes : colFlexes);
+
+    lengths.assign(flexes.size(), unset);
+    for (const Item &item : items) {
+        const int span = (rows ? item.rowSpan : item.colSpan);
+        const int line = (rows ? item.row : item.col);
+        if (span == 1 && flexes[line].weight == 0) {
+            const int policy = rows ? item.widget->getDesiredHeight()
+                                    : item.widget->getDesiredWidth();
+            lengths[line] = combinePolicies(lengths[line], policy);
+        }
+    }
+
+    for (const Item &item : items) {
+        const int span = (rows ? item.rowSpan : item.colSpan);
+        if (span > 1) {
+            const int from = (rows ? item.row : item.col);
+            const int policy = rows ? item.widget->getDesiredHeight()
+                                    : item.widget->getDesiredWidth();
+            spreadPolicy(flexes, from, from + span, policy);
+        }
+    }
+
+    for (unsigned int i = 0U; i < lengths.size(); ++i) {
+        if (flexes[i].weight > 0) {
+            lengths[i] = getFlexPolicy(flexes[i]);
+        } else if (lengths[i] == unset) {
+            lengths[i] = 0;
+        }
+    }
+}
+
+void
+Grid::spreadPolicy(const std::vector<Flex> &flexes, int from, int to,
+                   int policy)
+{
+    int have = 0;
+    int nAdjustable = 0;
+    for (int i = from; i < to; ++i) {
+        if (flexes[i].weight > 0) {
+            have += flexes[i].min;
+        } else {
+            ++nAdjustable;
+            if (lengths[i] != unset && !isFiller(lengths[i])) {
+                have += std::abs(lengths[i]);
+            }
+        }
+    }
+
+    // Fillers only make unoccupied rows or columns fillers as well.
+    if (isFiller(policy)) {
+        for (int i = from; i < to; ++i) {
+            if (flexes[i].weight == 0 && lengths[i] == unset) {
+                lengths[i] = policy;
+            }
+        }
+        return;
+    }
+
+    if (nAdjustable == 0) {
+        return;
+    }
+
+    const int lack = std::max(0, std::abs(policy) - have);
+    int left = nAdjustable;
+    int lackLeft = lack;
+    for (int i = from; i < to; ++i) {
+        if (flexes[i].weight > 0) {
+            continue;
+        }
+
+        const int share = lackLeft/left;
+        lackLeft -= share;
+        --left;
+
+        if (lengths[i] == unset) {
+            // Occupied row or column shouldn't collapse.
+            lengths[i] = -std::max(share, 1);
+        } else if (share > 0 && !isFiller(lengths[i])) {
+            lengths[i] = -(std::abs(lengths[i]) + share);
+        }
+    }
+}
+
+int
+Grid::computeDesired(bool rows)
+{
+    computePolicies(rows);
+
+    int total = 0;
+    bool flexible = false;
+    bool allFillers = !lengths.empty();
+    for (int policy : lengths) {
+        if (isFiller(policy)) {
+            flexible = true;
+            continue;
+        }
+
+        allFillers = false;
+        total += std::abs(policy);
+        if (policy < 0) {
+            flexible = true;
+        }
+    }
+
+    if (allFillers) {
+        return std::numeric_limits<int>::min();
+    }
+    return (flexible ? -total : total);
+}
+
+// Combines size policies of widgets that share a row or a column.  Fillers
+// matter only if there is nothing else.
+static int
+combinePolicies(int a, int b)
+{
+    if (a == unset || isFiller(a)) {
+        return b;
+    }
+    if (isFiller(b)) {
+        return a;
+    }
+
+    const int length = std::max(std::abs(a), std::abs(b));
+    return (a < 0 || b < 0 ? -length : length);
+}
+
+// Computes positions of consecutive lengths.  The last element of `offsets`
+// is the total length.
+static void
+computeOffsets(const std::vector<int> &lengths, std::vector<int> &offsets)
+{
+    offsets.clear();
+    offsets.push_back(0);
+    for (int length : lengths) {
+        offsets.push_back(offsets.back() + length);
+    }
+}
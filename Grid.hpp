@@ -0,0 +1,104 @@
+// libcursed -- C++ classes for dealing with curses
+// Copyright (C) 2022 xaizek <xaizek@posteo.net>
+//
+// This file is part of libcursed.
+//
+// libcursed is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// libcursed is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with libcursed.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef LIBCURSED__GRID_HPP__
+#define LIBCURSED__GRID_HPP__
+
+#include <vector>
+
+#include "guts/Widget.hpp"
+#include "Track.hpp"
+
+namespace cursed {
+
+// Organizes widgets in rows and columns, which can be spanned by widgets.
+// Size policy of a row or a column is combined from size policies of widgets
+// that occupy only that row or column unless it has flex constraints.  Then
+// lengths that widgets spanning several rows or columns lack are spread over
+// the spanned rows or columns, which are made flexible.  All rows and columns
+// are laid out at once, so columns of all rows line up.
+class Grid : public guts::Widget
+{
+public:
+    // Constructs a grid of specified dimensions.  Throws
+    // `std::invalid_argument` if any of them is negative.
+    Grid(int rows, int cols);
+
+public:
+    // Adds item to the grid occupying specified cells.  Throws
+    // `std::invalid_argument` if the cells are outside of the grid.
+    void addItem(Widget *w, int row, int col, int rowSpan = 1,
+                 int colSpan = 1);
+
+    // Sets flex constraints of a row (should be a valid index).  Zero weight
+    // makes size of the row depend on its widgets.
+    void setRowFlex(int row, Flex flex);
+    // Sets flex constraints of a column (should be a valid index).  Zero
+    // weight makes size of the column depend on its widgets.
+    void setColumnFlex(int col, Flex flex);
+
+private:
+    // Notifies widget of new position and size.
+    virtual void placed(guts::Pos newPos, guts::Size newSize) override;
+
+    // Updates state of this widget to be published on the screen.
+    virtual void draw() override;
+
+    // Retrieves vertical size policy.
+    // Positive number or zero means exactly that much.
+    // Negative number means at least that much in magnitude.
+    virtual int desiredHeight() override;
+    // Retrieves horizontal size policy.
+    // Positive number or zero means exactly that much.
+    // Negative number means at least that much in magnitude.
+    virtual int desiredWidth() override;
+
+    // Computes size policies of rows or columns into `lengths`.
+    void computePolicies(bool rows);
+    // Makes rows or columns in [from, to) that are spanned by a widget provide
+    // as much space as its size policy asks for.
+    void spreadPolicy(const std::vector<Flex> &flexes, int from, int to,
+                      int policy);
+    // Computes size policy of the whole grid along one of directions.
+    int computeDesired(bool rows);
+
+private:
+    // Child widget along with its location.
+    struct Item
+    {
+        Widget *widget; // Child widget.
+        int row;        // Top row.
+        int col;        // Leftmost column.
+        int rowSpan;    // Number of rows.
+        int colSpan;    // Number of columns.
+    };
+
+    std::vector<Item> items;       // Child widgets of this grid.
+    std::vector<Flex> rowFlexes;   // Flex constraints of rows.
+    std::vector<Flex> colFlexes;   // Flex constraints of columns.
+    // Scratch buffers for layout which keep their capacity between calls.
+    std::vector<int> lengths;      // Size policies of rows or columns.
+    std::vector<int> heights;      // Computed heights of rows.
+    std::vector<int> widths;       // Computed widths of columns.
+    std::vector<int> rowOffsets;   // Positions of rows.
+    std::vector<int> colOffsets;   // Positions of columns.
+};
+
+}
+
+#endif // LIBCURSED__GRID_HPP__
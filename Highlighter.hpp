@@ -0,0 +1,48 @@
+// libcursed -- C++ classes for dealing with curses
+// Copyright (C) 2022 xaizek <xaizek@posteo.net>
+//
+// This file is part of libcursed.
+//
+// libcursed is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// libcursed is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with libcursed.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef LIBCURSED__HIGHLIGHTER_HPP__
+#define LIBCURSED__HIGHLIGHTER_HPP__
+
+#include <string>
+
+#include "ColorTree.hpp"
+
+namespace cursed {
+
+// Tokenizer that formats plain lines of `Text` widget.  Lines are processed in
+// order with each one starting in the state left by the previous line (e.g.,
+// whether a multiline comment is open).  Only lines up to the displayed ones
+// are processed.
+class Highlighter
+{
+protected:
+    // No base class destruction.
+    ~Highlighter() = default;
+
+public:
+    // Retrieves state at the start of text.
+    virtual int getInitialState() = 0;
+    // Formats a line that starts in the `state` and updates the `state` to be
+    // the one at the end of the line.  Text of the result must match the line.
+    virtual ColorTree highlight(const std::wstring &line, int &state) = 0;
+};
+
+}
+
+#endif // LIBCURSED__HIGHLIGHTER_HPP__
@@ -25,7 +25,7 @@
 
 using namespace cursed;
 
-Label::Label(ColorTree initText) : text(std::move(initText))
+Label::Label(ColorTree initText) : text(std::move(initText)), width(0)
 {
     computeWidth();
 }
@@ -44,7 +44,11 @@ Label::computeWidth()
     text.visit([&newWidth](const std::wstring &text, const Format &/*format*/) {
         newWidth += text.length();
     });
-    width = std::max(1, newWidth);
+    newWidth = std::max(1, newWidth);
+    if (newWidth != width) {
+        width = newWidth;
+        invalidateSize();
+    }
 }
 
 void
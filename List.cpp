@@ -19,18 +19,28 @@
 #include "List.hpp"
 
 #include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cwctype>
 
+#include <algorithm>
 #include <iomanip>
 #include <sstream>
+#include <stdexcept>
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
+#include "guts/Parallel.hpp"
 #include "guts/Size.hpp"
 
 using namespace cursed;
 using namespace cursed::guts;
 
+static std::uint64_t makeMask(const std::wstring &text);
+static int scoreMatch(const std::wstring &text, const std::wstring &query);
+
 // Computes number of digits in a positive number (including zero).
 static inline int
 countWidth(int n)
@@ -45,16 +55,65 @@ countWidth(int n)
     return width;
 }
 
-List::List() : height(0)
+// Maps selected positions in [0; size) through `movePos`, which returns new
+// position or -1 for items that are gone.  Consecutive positions that stay
+// consecutive are carried over as a single range.
+template <typename F>
+static RangeSet
+mapSelection(const RangeSet &selection, int size, F movePos)
+{
+    std::vector<Range> runs;
+    for (const Range &range : selection.getRanges()) {
+        for (int pos = range.from; pos < std::min(range.to, size); ++pos) {
+            const int newPos = movePos(pos);
+            if (newPos < 0) {
+                continue;
+            }
+            if (!runs.empty() && runs.back().to == newPos) {
+                ++runs.back().to;
+            } else {
+                runs.push_back({ newPos, newPos + 1 });
+            }
+        }
+    }
+
+    std::sort(runs.begin(), runs.end(),
+              [](const Range &a, const Range &b) { return a.from < b.from; });
+
+    RangeSet newSelection;
+    for (const Range &run : runs) {
+        newSelection.add(run.from, run.to);
+    }
+    return newSelection;
+}
+
+// Bits of highlight state of cached rows.
+static const int currentState = 1;
+static const int selectedState = 2;
+
+List::List() : height(0), lineNumWidth(0), workers(0)
 {
     currentHi.setReversed(true);
     currentHi.setForeground(Color::Yellow);
+    selectedHi.setBold(true);
+    selectedHi.setForeground(Color::Cyan);
 }
 
 void
 List::setItems(std::vector<ColorTree> newItems)
 {
-    items = std::move(newItems);
+    items.clear();
+    items.reserve(newItems.size());
+    for (ColorTree &item : newItems) {
+        items.emplace_back(std::move(item));
+    }
+
+    keys.clear();
+    shadows.clear();
+    shadows.resize(items.size());
+    masks.clear();
+    cache.clear();
+    applyFilter(false);
     ListLike::reset();
 }
 
@@ -62,27 +121,367 @@ void
 List::setItem(int pos, ColorTree newValue)
 {
     items[pos] = std::move(newValue);
+    shadows[pos].reset();
+    itemChanged(pos);
+}
+
+void
+List::itemChanged(int pos)
+{
+    updateMask(pos);
+    if (filter.empty()) {
+        cache.invalidate(pos);
+        return;
+    }
+
+    // The item can change its position or disappear, selection and cursor
+    // follow items.
+    const int oldSize = getSize();
+    const std::vector<int> oldView = view;
+
+    cache.clear();
+    applyFilter(false);
+
+    const int newPos = followItems(oldSize, oldView);
+    moveToPos(newPos < 0 ? getPos() : newPos);
+}
+
+void
+List::setPlainItems(std::vector<std::string> newItems)
+{
+    items.clear();
+    items.reserve(newItems.size());
+    for (std::string &item : newItems) {
+        items.emplace_back(std::move(item));
+    }
+
+    keys.clear();
+    shadows.clear();
+    shadows.resize(items.size());
+    masks.clear();
+    cache.clear();
+    applyFilter(false);
+    ListLike::reset();
+}
+
+void
+List::setPlainItem(int pos, std::string newValue)
+{
+    items[pos] = std::move(newValue);
+    shadows[pos].reset();
+    itemChanged(pos);
+}
+
+void
+List::updateItems(std::vector<std::string> newKeys,
+                  std::vector<ColorTree> newItems)
+{
+    std::vector<Cell> newCells;
+    newCells.reserve(newItems.size());
+    for (ColorTree &item : newItems) {
+        newCells.emplace_back(std::move(item));
+    }
+    updateCells(std::move(newKeys), std::move(newCells));
+}
+
+void
+List::updatePlainItems(std::vector<std::string> newKeys,
+                       std::vector<std::string> newItems)
+{
+    std::vector<Cell> newCells;
+    newCells.reserve(newItems.size());
+    for (std::string &item : newItems) {
+        newCells.emplace_back(std::move(item));
+    }
+    updateCells(std::move(newKeys), std::move(newCells));
 }
 
-std::wstring
+const std::wstring &
 List::getCurrent() const
 {
-    if (items.empty()) {
-        return std::wstring();
+    static const std::wstring empty;
+    return (getSize() == 0 ? empty : getText(getItemIndex(getPos())));
+}
+
+int
+List::getCurrentIndex() const
+{
+    return (getSize() == 0 ? -1 : getItemIndex(getPos()));
+}
+
+void
+List::setFilter(const std::wstring &query)
+{
+    std::wstring newFilter;
+    newFilter.reserve(query.size());
+    for (wchar_t c : query) {
+        newFilter += std::towlower(c);
     }
 
-    std::wstring current;
-    items[getPos()].visit([&current](const std::wstring &text,
-                                     const Format &/*format*/) {
-        current += text;
-    });
-    return current;
+    // Items that don't match a query also don't match its extension.
+    const bool refine = !filter.empty()
+                     && newFilter.compare(0, filter.size(), filter) == 0;
+    const int oldSize = getSize();
+    // Cursor stays on the same screen row if possible.
+    const int offset = (oldSize == 0 || height == 0 ? 0 : getPos() - getTop());
+    const std::vector<int> oldView = (filter.empty() ? std::vector<int>()
+                                                     : std::move(view));
+
+    filter = std::move(newFilter);
+    cache.clear();
+    applyFilter(refine);
+
+    // Selection and cursor follow items, cursor goes to the best match if its
+    // item got filtered out.
+    const int newPos = followItems(oldSize, oldView);
+    moveToPos(newPos < 0 ? 0 : newPos);
+    setTop(newPos < 0 ? 0 : std::max(0, std::min(getPos() - offset,
+                                                 getSize() - height)));
+}
+
+const std::wstring &
+List::getFilter() const
+{
+    return filter;
+}
+
+void
+List::setWorkers(int n)
+{
+    workers = n;
+}
+
+void
+List::updateCells(std::vector<std::string> newKeys,
+                  std::vector<Cell> newCells)
+{
+    if (newKeys.size() != newCells.size()) {
+        throw std::invalid_argument("Number of keys and items differ");
+    }
+
+    const int oldSize = getSize();
+    // Cursor stays on the same screen row if possible.
+    const int offset = (oldSize == 0 || height == 0 ? 0 : getPos() - getTop());
+    const std::vector<int> oldView = (filter.empty() ? std::vector<int>()
+                                                     : std::move(view));
+
+    std::unordered_map<std::string, int> oldIndexes;
+    oldIndexes.reserve(keys.size());
+    for (int i = 0; i < static_cast<int>(keys.size()); ++i) {
+        oldIndexes.emplace(keys[i], i);
+    }
+
+    // For every new item: index of the old item with the same key and
+    // unchanged contents or -1.  For every old item: index of the new item
+    // with the same key or -1.
+    std::vector<int> origins(newCells.size(), -1);
+    std::vector<int> moves(items.size(), -1);
+    for (int i = 0; i < static_cast<int>(newKeys.size()); ++i) {
+        auto it = oldIndexes.find(newKeys[i]);
+        if (it == oldIndexes.end()) {
+            continue;
+        }
+
+        const int old = it->second;
+        moves[old] = i;
+        if (items[old] == newCells[i]) {
+            origins[i] = old;
+        }
+    }
+
+    // Text and sets of characters of unchanged items are reused.
+    std::vector<std::unique_ptr<std::wstring>> newShadows(newCells.size());
+    std::vector<std::uint64_t> newMasks(masks.empty() ? 0U : newCells.size());
+    for (int i = 0; i < static_cast<int>(origins.size()); ++i) {
+        if (origins[i] >= 0) {
+            newShadows[i] = std::move(shadows[origins[i]]);
+            if (!masks.empty()) {
+                newMasks[i] = masks[origins[i]];
+            }
+        }
+    }
+
+    items = std::move(newCells);
+    keys = std::move(newKeys);
+    shadows = std::move(newShadows);
+    masks = std::move(newMasks);
+    for (int i = 0; i < static_cast<int>(origins.size()); ++i) {
+        if (origins[i] < 0) {
+            updateMask(i);
+        }
+    }
+
+    applyFilter(false);
+
+    // A row stays valid if it displays the same unchanged item at the same
+    // index (line numbers are part of rows).
+    const int newSize = getSize();
+    for (int row = 0; row < std::max(oldSize, newSize); ++row) {
+        if (row >= oldSize || row >= newSize) {
+            cache.invalidate(row);
+            continue;
+        }
+
+        const int oldIndex = (oldView.empty() ? row : oldView[row]);
+        const int newIndex = getItemIndex(row);
+        if (newIndex != oldIndex || origins[newIndex] != oldIndex) {
+            cache.invalidate(row);
+        }
+    }
+
+    // Maps old position to a new one or -1 if the item is gone.
+    std::vector<int> positions;
+    if (!filter.empty()) {
+        positions.assign(items.size(), -1);
+        for (int pos = 0; pos < newSize; ++pos) {
+            positions[view[pos]] = pos;
+        }
+    }
+    auto movePos = [&](int pos) {
+        const int index = moves[oldView.empty() ? pos : oldView[pos]];
+        if (index < 0 || positions.empty()) {
+            return index;
+        }
+        return positions[index];
+    };
+
+    // Selection follows items.
+    if (!getSelection().empty()) {
+        setSelection(mapSelection(getSelection(), oldSize, movePos));
+    }
+
+    int newPos = (oldSize == 0 ? -1 : movePos(getPos()));
+    moveToPos(newPos < 0 ? getPos() : newPos);
+    setTop(std::max(0, std::min(getPos() - offset, newSize - height)));
+}
+
+int
+List::followItems(int oldSize, const std::vector<int> &oldView)
+{
+    // Maps item index to its new position or -1 if it's not displayed.
+    std::vector<int> positions;
+    if (!filter.empty()) {
+        positions.assign(items.size(), -1);
+        for (int pos = 0; pos < static_cast<int>(view.size()); ++pos) {
+            positions[view[pos]] = pos;
+        }
+    }
+    auto movePos = [&](int pos) {
+        const int index = (oldView.empty() ? pos : oldView[pos]);
+        return (filter.empty() ? index : positions[index]);
+    };
+
+    if (!getSelection().empty()) {
+        setSelection(mapSelection(getSelection(), oldSize, movePos));
+    }
+
+    return (oldSize == 0 ? -1 : movePos(getPos()));
+}
+
+const std::wstring &
+List::getText(int i) const
+{
+    std::unique_ptr<std::wstring> &shadow = shadows[i];
+    if (shadow == nullptr) {
+        shadow.reset(new std::wstring());
+        items[i].visit([&shadow](const std::wstring &text,
+                                 const Format &/*format*/) {
+            *shadow += text;
+        });
+    }
+    return *shadow;
+}
+
+int
+List::getItemIndex(int pos) const
+{
+    return (filter.empty() ? pos : view[pos]);
+}
+
+void
+List::applyFilter(bool refine)
+{
+    if (filter.empty()) {
+        matched.clear();
+        view.clear();
+        return;
+    }
+
+    // Sets of characters are computed once and are used to quickly skip items
+    // that lack some characters of the filter.
+    if (masks.empty() && !items.empty()) {
+        masks.resize(items.size());
+        parallelFor(items.size(), countChunks(items.size(), workers),
+                    [this](int /*chunk*/, std::size_t from, std::size_t to) {
+                        for (std::size_t i = from; i < to; ++i) {
+                            masks[i] = makeMask(getText(i));
+                        }
+                    });
+    }
+
+    const std::uint64_t filterMask = makeMask(filter);
+    const std::size_t nCandidates = (refine ? matched.size() : items.size());
+
+    // Candidates are scored by chunks in parallel and then results of chunks
+    // are combined in order, so matches stay ordered by index.
+    struct Match
+    {
+        int score;
+        int index;
+    };
+    const int nChunks = countChunks(nCandidates, workers);
+    std::vector<std::vector<Match>> found(nChunks);
+    parallelFor(nCandidates, nChunks,
+                [&](int chunk, std::size_t from, std::size_t to) {
+                    for (std::size_t j = from; j < to; ++j) {
+                        const int i = (refine ? matched[j] : j);
+                        if ((filterMask & ~masks[i]) != 0U) {
+                            continue;
+                        }
+
+                        const int score = scoreMatch(getText(i), filter);
+                        if (score >= 0) {
+                            found[chunk].push_back({ score, i });
+                        }
+                    }
+                });
+
+    std::vector<Match> matches;
+    matches.reserve(nCandidates);
+    for (const std::vector<Match> &chunkMatches : found) {
+        matches.insert(matches.end(), chunkMatches.cbegin(),
+                       chunkMatches.cend());
+    }
+
+    matched.clear();
+    for (const Match &match : matches) {
+        matched.push_back(match.index);
+    }
+
+    // Best matches go first, equal ones stay in order of indexes.
+    std::stable_sort(matches.begin(), matches.end(),
+                     [](const Match &a, const Match &b) {
+                         return a.score > b.score;
+                     });
+    view.clear();
+    view.reserve(matches.size());
+    for (const Match &match : matches) {
+        view.push_back(match.index);
+    }
+}
+
+void
+List::updateMask(int i)
+{
+    if (!masks.empty()) {
+        masks[i] = makeMask(getText(i));
+    }
 }
 
 void
 List::draw()
 {
-    if (items.empty()) {
+    if (getSize() == 0) {
         ListLike::reset();
 
         win.erase();
@@ -90,33 +489,60 @@ List::draw()
         return;
     }
 
-    int lineNumWidth = countWidth(items.size());
+    // Numbers of items don't change on filtering.
+    int newLineNumWidth = countWidth(items.size());
+    if (newLineNumWidth != lineNumWidth) {
+        lineNumWidth = newLineNumWidth;
+        cache.clear();
+    }
 
     win.erase();
     int line = 0;
     int top = getTop();
     int pos = getPos();
     for (int i = top; i < top + height; ++i, ++line) {
-        if (i == static_cast<int>(items.size())) {
+        if (i == getSize()) {
             break;
         }
 
         wmove(win, line, 0);
         wclrtoeol(win);
 
-        std::wostringstream oss;
-        oss << L' '
-            << std::setw(lineNumWidth) << std::to_wstring(i + 1) << L": ";
-
-        Format hi = itemHi;
-        if (i == pos) {
-            hi += currentHi;
+        const int state = (i == pos ? currentState : 0)
+                        | (isSelected(i) ? selectedState : 0);
+        const std::vector<Run> *runs = cache.find(i, state);
+        if (runs == nullptr) {
+            runs = &renderRow(i, state);
         }
-        win.print(hi(oss.str() + ColorTree(items[i]) + L" "));
+        win.print(*runs, 0, true);
     }
     wnoutrefresh(win);
 }
 
+const std::vector<Run> &
+List::renderRow(int i, int state)
+{
+    const int index = getItemIndex(i);
+
+    std::wostringstream oss;
+    oss << L' '
+        << std::setw(lineNumWidth) << std::to_wstring(index + 1) << L": ";
+
+    Format hi = itemHi;
+    if (state & selectedState) {
+        hi += selectedHi;
+    }
+    if (state & currentState) {
+        hi += currentHi;
+    }
+
+    std::vector<Run> &runs = cache.store(i, state);
+    appendRuns(runs, oss.str(), hi);
+    appendRuns(runs, items[index], hi);
+    appendRuns(runs, L" ", hi);
+    return runs;
+}
+
 int
 List::desiredHeight()
 {
@@ -133,13 +559,16 @@ void
 List::placed(Pos newPos, Size newSize)
 {
     WindowWidget::placed(newPos, newSize);
-    height = newSize.lines;
+    if (height != newSize.lines) {
+        height = newSize.lines;
+        cache.resize(height);
+    }
 }
 
 int
 List::getSize() const
 {
-    return items.size();
+    return (filter.empty() ? items.size() : view.size());
 }
 
 int
@@ -147,3 +576,57 @@ List::getHeight() const
 {
     return height;
 }
+
+// Computes set of characters of a string ignoring case.  Letters and digits
+// have dedicated bits, other characters share the rest.
+static std::uint64_t
+makeMask(const std::wstring &text)
+{
+    std::uint64_t mask = 0U;
+    for (wchar_t c : text) {
+        c = std::towlower(c);
+
+        int bit;
+        if (c >= L'a' && c <= L'z') {
+            bit = c - L'a';
+        } else if (c >= L'0' && c <= L'9') {
+            bit = 26 + (c - L'0');
+        } else {
+            bit = 36 + static_cast<unsigned int>(c)%28U;
+        }
+        mask |= std::uint64_t(1) << bit;
+    }
+    return mask;
+}
+
+// Scores fuzzy match of a query (in lower case) against text.  Returns -1 if
+// text doesn't contain all characters of the query in order.  Consecutive
+// characters and characters at starts of words score higher.
+static int
+scoreMatch(const std::wstring &text, const std::wstring &query)
+{
+    int score = 0;
+    std::size_t q = 0U;
+    std::size_t prev = 0U;
+    for (std::size_t i = 0U; i < text.size() && q < query.size(); ++i) {
+        if (static_cast<wchar_t>(std::towlower(text[i])) != query[q]) {
+            continue;
+        }
+
+        score += 1;
+        if (q > 0U && prev + 1U == i) {
+            score += 4;
+        }
+        if (i == 0U || !std::iswalnum(text[i - 1U])) {
+            score += 2;
+        }
+
+        prev = i;
+        ++q;
+    }
+
+    if (q != query.size()) {
+        return -1;
+    }
+    return score;
+}
@@ -19,9 +19,14 @@
 #ifndef LIBCURSED__LIST_HPP__
 #define LIBCURSED__LIST_HPP__
 
+#include <cstdint>
+
+#include <memory>
 #include <string>
 #include <vector>
 
+#include "guts/Cell.hpp"
+#include "guts/RowCache.hpp"
 #include "guts/WindowWidget.hpp"
 #include "ColorTree.hpp"
 #include "ListLike.hpp"
@@ -46,9 +51,41 @@ public:
     // Updates an item at position (should be a valid index).
     void setItem(int pos, ColorTree newValue);
 
+    // Assigns list of plain items in UTF-8.  Such items are stored as strings
+    // without allocating a tree per item.
+    void setPlainItems(std::vector<std::string> newItems);
+    // Updates an item at position (should be a valid index) with plain text in
+    // UTF-8.
+    void setPlainItem(int pos, std::string newValue);
+
+    // Replaces list of items with items identified by keys, which is meant for
+    // periodic refreshes.  Cursor stays on an item with the same key and only
+    // rows that changed are redrawn.  Throws `std::invalid_argument` if number
+    // of keys doesn't match number of items.
+    void updateItems(std::vector<std::string> newKeys,
+                     std::vector<ColorTree> newItems);
+    // Same as `updateItems()`, but for plain items in UTF-8.
+    void updatePlainItems(std::vector<std::string> newKeys,
+                          std::vector<std::string> newItems);
+
     // Returns value of the element under the cursor or an empty string for
-    // empty list.
-    std::wstring getCurrent() const;
+    // empty list.  The reference is valid until the item is changed.
+    const std::wstring & getCurrent() const;
+    // Retrieves index of the element under the cursor among all items or -1
+    // if there are no visible items.
+    int getCurrentIndex() const;
+
+    // Makes the list display only items that fuzzily match the query (contain
+    // all of its characters in the same order ignoring case) ordered by
+    // quality of the match.  Empty query displays all items.  Filter is
+    // reapplied after items change.
+    void setFilter(const std::wstring &query);
+    // Retrieves current filter.
+    const std::wstring & getFilter() const;
+
+    // Sets maximum number of threads for filtering.  Zero means number of
+    // hardware threads, one disables parallelism.
+    void setWorkers(int n);
 
     // Retrieves number of elements in the list.
     virtual int getSize() const override;
@@ -57,6 +94,34 @@ private:
     // Updates state of this widget to be published on the screen.
     virtual void draw() override;
 
+    // Renders row of the list into the cache.  Returns rendered runs.
+    const std::vector<guts::Run> & renderRow(int i, int state);
+
+    // Retrieves text of an item without formatting.  The text is computed on
+    // the first use.  Different items can be processed in parallel.
+    const std::wstring & getText(int i) const;
+
+    // Replaces items with keyed ones preserving state of items with the same
+    // keys.
+    void updateCells(std::vector<std::string> newKeys,
+                     std::vector<guts::Cell> newCells);
+
+    // Updates state after an item at index `pos` was replaced.
+    void itemChanged(int pos);
+    // Moves selection to positions of the same items after view has changed.
+    // `oldView` is the previous view (empty for unfiltered list) of `oldSize`
+    // items.  Returns new position of the current item or -1 if it's gone.
+    int followItems(int oldSize, const std::vector<int> &oldView);
+
+    // Retrieves index of an item displayed at a position.
+    int getItemIndex(int pos) const;
+    // Updates list of displayed items according to the filter.  `refine`
+    // means that the filter was extended and only items that matched it
+    // before need to be checked.
+    void applyFilter(bool refine);
+    // Updates prefilter data of an item if it's in use.
+    void updateMask(int i);
+
     // Retrieves vertical size policy.
     // Positive number or zero means exactly that much.
     // Negative number means at least that much in magnitude.
@@ -73,10 +138,22 @@ private:
     virtual int getHeight() const override;
 
 private:
-    std::vector<ColorTree> items; // List of items.
-    int height;                   // Screen height.
-    Format itemHi;                // Visual style of an item.
-    Format currentHi;             // Visual style of the current item.
+    std::vector<guts::Cell> items; // List of items.
+    std::vector<std::string> keys; // Keys of items or empty if not keyed.
+    // Plain text of items or `nullptr` if it wasn't needed yet.
+    mutable std::vector<std::unique_ptr<std::wstring>> shadows;
+    int height;                    // Screen height.
+    Format itemHi;                 // Visual style of an item.
+    Format currentHi;              // Visual style of the current item.
+    Format selectedHi;             // Visual style of selected items.
+    guts::RowCache cache;          // Rendered rows.
+    int lineNumWidth;              // Width of line numbers of cached rows.
+
+    std::wstring filter;               // Current filter (in lower case).
+    std::vector<int> matched;          // Matched items in order of indexes.
+    std::vector<int> view;             // Displayed items when filtering.
+    std::vector<std::uint64_t> masks;  // Sets of characters of items.
+    int workers;                       // Maximum number of threads.
 };
 
 }
@@ -20,7 +20,13 @@
 
 #include <cassert>
 
+#include <algorithm>
+#include <utility>
+
+#include "guts/RangeSet.hpp"
+
 using namespace cursed;
+using namespace cursed::guts;
 
 ListLike::ListLike()
 {
@@ -112,11 +118,60 @@ ListLike::getPos() const
     return pos;
 }
 
+void
+ListLike::select(int from, int to)
+{
+    selection.add(std::max(from, 0), std::min(to, getSize()));
+}
+
+void
+ListLike::unselect(int from, int to)
+{
+    selection.remove(from, to);
+}
+
+void
+ListLike::invertSelection(int from, int to)
+{
+    selection.invert(std::max(from, 0), std::min(to, getSize()));
+}
+
+void
+ListLike::selectAll()
+{
+    select(0, getSize());
+}
+
+void
+ListLike::clearSelection()
+{
+    selection.clear();
+}
+
+bool
+ListLike::isSelected(int pos) const
+{
+    return selection.contains(pos);
+}
+
+const RangeSet &
+ListLike::getSelection() const
+{
+    return selection;
+}
+
+void
+ListLike::setSelection(RangeSet newSelection)
+{
+    selection = std::move(newSelection);
+}
+
 void
 ListLike::reset()
 {
     top = 0;
     pos = 0;
+    selection.clear();
 }
 
 int
@@ -135,3 +190,9 @@ ListLike::getTop()
     }
     return top;
 }
+
+void
+ListLike::setTop(int newTop)
+{
+    top = newTop;
+}
@@ -19,6 +19,8 @@
 #ifndef LIBCURSED__LISTLIKE_HPP__
 #define LIBCURSED__LISTLIKE_HPP__
 
+#include "guts/RangeSet.hpp"
+
 namespace cursed {
 
 // Provides cursor and scrolling functionality common for lists.
@@ -53,11 +55,30 @@ public:
     // Retrieves current position.
     int getPos() const;
 
+    // Selects elements at positions in the range [from, to).
+    void select(int from, int to);
+    // Unselects elements at positions in the range [from, to).
+    void unselect(int from, int to);
+    // Toggles selection of elements at positions in the range [from, to).
+    void invertSelection(int from, int to);
+    // Selects all elements.
+    void selectAll();
+    // Unselects all elements.
+    void clearSelection();
+    // Checks whether element at the position is selected.
+    bool isSelected(int pos) const;
+    // Retrieves positions of selected elements.
+    const guts::RangeSet & getSelection() const;
+
 protected:
-    // Resets scroll and cursor positions.
+    // Resets scroll and cursor positions and clears selection.
     void reset();
     // Retrieves scroll position.
     int getTop();
+    // Sets scroll position.  It's corrected to keep cursor visible.
+    void setTop(int newTop);
+    // Replaces selection.
+    void setSelection(guts::RangeSet newSelection);
 
 private:
     // Retrieves number of elements in the list.
@@ -67,8 +88,9 @@ private:
     virtual int getHeight() const = 0;
 
 private:
-    int pos; // Current cursor position.
-    int top; // Scroll position (first element to display).
+    int pos;                  // Current cursor position.
+    int top;                  // Scroll position (first element to display).
+    guts::RangeSet selection; // Selected positions.
 };
 
 }
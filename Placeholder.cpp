@@ -31,13 +31,21 @@ Placeholder::Placeholder() : widget(nullptr)
 void
 Placeholder::fill(guts::Widget *filling)
 {
+    if (widget != nullptr) {
+        widget->setParent(nullptr);
+    }
+
     widget = filling;
+    if (widget != nullptr) {
+        widget->setParent(this);
+    }
+    invalidateSize();
 }
 
 void
 Placeholder::draw()
 {
-    if (widget != nullptr) {
+    if (widget != nullptr && !widget->isHidden()) {
         widget->draw();
     }
 }
@@ -77,7 +77,9 @@ Screen::draw()
 
     guts::ColorManager::get().reset();
     for (Widget *widget : mainWidgets) {
-        widget->draw();
+        if (!widget->isHidden()) {
+            widget->draw();
+        }
     }
 
     if (cursorWidget != nullptr) {
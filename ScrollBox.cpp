@@ -0,0 +1,218 @@
+// libcursed -- C++ classes for dealing with curses
+// Copyright (C) 2022 xaizek <xaizek@posteo.net>
+//
+// This file is part of libcursed.
+//
+// libcursed is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// libcursed is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with libcursed.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "ScrollBox.hpp"
+
+#include <cstdlib>
+
+#include <algorithm>
+#include <vector>
+
+#include "guts/Layout.hpp"
+
+using namespace cursed;
+using namespace cursed::guts;
+
+static int getItemHeight(Widget *w);
+
+ScrollBox::ScrollBox() : offset(0), first(0), last(0), changed(0)
+{ }
+
+void
+ScrollBox::addItem(Widget *w)
+{
+    changed = std::min<int>(changed, widgets.size());
+    widgets.push_back(w);
+    w->setParent(this);
+    invalidateSize();
+}
+
+void
+ScrollBox::scrollTo(int line)
+{
+    updateOffsets();
+    if (offsets.empty()) {
+        offset = line;
+        return;
+    }
+
+    setOffset(getItemStart(line));
+}
+
+void
+ScrollBox::scrollDown(int by)
+{
+    updateOffsets();
+    if (offsets.empty()) {
+        offset += by;
+        return;
+    }
+
+    // Start of the first item at or below the line.
+    auto it = std::lower_bound(offsets.cbegin(), offsets.cend() - 1,
+                               offset + by);
+    setOffset(it == offsets.cend() - 1 ? offsets.back() : *it);
+}
+
+void
+ScrollBox::scrollUp(int by)
+{
+    scrollTo(offset - by);
+}
+
+void
+ScrollBox::scrollToItem(int i)
+{
+    updateOffsets();
+    if (offsets.empty()) {
+        return;
+    }
+
+    if (offsets[i] < offset) {
+        setOffset(offsets[i]);
+    } else if (offsets[i + 1] > offset + size.lines) {
+        // Item that doesn't fit is displayed from its first line.
+        scrollDown(std::min(offsets[i], offsets[i + 1] - size.lines) - offset);
+    }
+}
+
+int
+ScrollBox::getOffset() const
+{
+    return offset;
+}
+
+int
+ScrollBox::getContentHeight() const
+{
+    return (offsets.empty() ? 0 : offsets.back());
+}
+
+void
+ScrollBox::placed(Pos newPos, Size newSize)
+{
+    pos = newPos;
+    size = newSize;
+
+    // Heights of items don't depend on width, so offsets are recomputed only
+    // if items have changed.
+    computeOffsets();
+    setOffset(getItemStart(offset));
+}
+
+void
+ScrollBox::childResized(Widget *child)
+{
+    auto it = std::find(widgets.cbegin(), widgets.cend(), child);
+    changed = std::min<int>(changed, it - widgets.cbegin());
+}
+
+void
+ScrollBox::updateOffsets()
+{
+    // Items could have been added or resized since the last placement.
+    if (!offsets.empty() && changed < static_cast<int>(widgets.size())) {
+        computeOffsets();
+    }
+}
+
+void
+ScrollBox::computeOffsets()
+{
+    // Offsets up to the first changed item stay the same.
+    offsets.resize(changed + 1);
+    offsets.reserve(widgets.size() + 1U);
+    for (int i = changed; i < static_cast<int>(widgets.size()); ++i) {
+        offsets.push_back(offsets.back() + getItemHeight(widgets[i]));
+    }
+    changed = widgets.size();
+}
+
+int
+ScrollBox::getItemStart(int line) const
+{
+    auto it = std::upper_bound(offsets.cbegin() + 1, offsets.cend(), line);
+    return (it == offsets.cend() ? offsets.back() : *(it - 1));
+}
+
+void
+ScrollBox::setOffset(int newOffset)
+{
+    // The lowest position is the start of the first item after which
+    // everything fits or the start of the last item if it doesn't fit.
+    auto end = offsets.cend() - 1;
+    auto it = std::lower_bound(offsets.cbegin(), end,
+                               offsets.back() - size.lines);
+    const int maxOffset = (it != end ? *it
+                                     : it == offsets.cbegin() ? 0 : *(it - 1));
+
+    offset = std::max(0, std::min(newOffset, maxOffset));
+    placeVisible();
+}
+
+void
+ScrollBox::placeVisible()
+{
+    // Index of the first item that ends below the top line.
+    first = std::upper_bound(offsets.cbegin() + 1, offsets.cend(), offset)
+          - (offsets.cbegin() + 1);
+
+    const int bottom = offset + size.lines;
+    int i = first;
+    for (; i < static_cast<int>(widgets.size()) && offsets[i] < bottom; ++i) {
+        const int from = std::max(offsets[i], offset);
+        const int to = std::min(offsets[i + 1], bottom);
+        widgets[i]->place(Pos(pos.x, pos.y + from - offset),
+                          Size(to - from, size.cols));
+    }
+    last = i;
+}
+
+void
+ScrollBox::draw()
+{
+    for (int i = first; i < last; ++i) {
+        if (!widgets[i]->isHidden()) {
+            widgets[i]->draw();
+        }
+    }
+}
+
+int
+ScrollBox::desiredHeight()
+{
+    return -1;
+}
+
+int
+ScrollBox::desiredWidth()
+{
+    lengths.clear();
+    for (Widget *w : widgets) {
+        lengths.push_back(w->getDesiredWidth());
+    }
+    return calculateDesired(lengths);
+}
+
+// Computes number of lines taken by an item.
+static int
+getItemHeight(Widget *w)
+{
+    const int height = w->getDesiredHeight();
+    return (isFiller(height) ? 1 : std::abs(height));
+}
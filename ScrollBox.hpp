@@ -0,0 +1,109 @@
+// libcursed -- C++ classes for dealing with curses
+// Copyright (C) 2022 xaizek <xaizek@posteo.net>
+//
+// This file is part of libcursed.
+//
+// libcursed is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// libcursed is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with libcursed.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef LIBCURSED__SCROLLBOX_HPP__
+#define LIBCURSED__SCROLLBOX_HPP__
+
+#include <vector>
+
+#include "guts/Pos.hpp"
+#include "guts/Size.hpp"
+#include "guts/Widget.hpp"
+
+namespace cursed {
+
+// Vertical container that displays part of its widgets which can be scrolled.
+// Each widget gets as many lines as its height policy asks for (fillers get
+// one line).  Only widgets that are at least partially visible are placed and
+// drawn.  Scrolling stops at starts of widgets, so the top widget is displayed
+// from its first line, while the bottom one is shrunk to its visible part.
+class ScrollBox : public guts::Widget
+{
+public:
+    // Constructs an empty container.
+    ScrollBox();
+
+public:
+    // Adds item to the end of this container.
+    void addItem(Widget *w);
+
+    // Scrolls contents to make widget that contains specified line appear at
+    // the top (incorrect value is turned into closest bound).
+    void scrollTo(int line);
+    // Scrolls contents at least `by` lines down.
+    void scrollDown(int by = 1);
+    // Scrolls contents at least `by` lines up.
+    void scrollUp(int by = 1);
+    // Scrolls contents minimally to make item at the index (should be a valid
+    // index) fully visible if it fits.
+    void scrollToItem(int i);
+
+    // Retrieves number of the line displayed at the top.
+    int getOffset() const;
+    // Retrieves total height of all items.  Valid after the container was
+    // placed.
+    int getContentHeight() const;
+
+private:
+    // Notifies widget of new position and size.
+    virtual void placed(guts::Pos newPos, guts::Size newSize) override;
+    // Notifies container that size policy of its `child` (direct one) or of
+    // something inside of it might have changed.
+    virtual void childResized(Widget *child) override;
+
+    // Updates state of this widget to be published on the screen.
+    virtual void draw() override;
+
+    // Retrieves vertical size policy.
+    // Positive number or zero means exactly that much.
+    // Negative number means at least that much in magnitude.
+    virtual int desiredHeight() override;
+    // Retrieves horizontal size policy.
+    // Positive number or zero means exactly that much.
+    // Negative number means at least that much in magnitude.
+    virtual int desiredWidth() override;
+
+    // Computes positions of items if they are out of date.
+    void updateOffsets();
+    // Computes positions of items starting with the first changed one.
+    void computeOffsets();
+    // Retrieves start of the item that contains the line.
+    int getItemStart(int line) const;
+    // Sets scroll position (it's corrected to be within bounds) and places
+    // items that intersect viewport.
+    void setOffset(int newOffset);
+    // Places items that intersect viewport.
+    void placeVisible();
+
+private:
+    std::vector<Widget *> widgets; // Child widgets of this container.
+    // Positions of items within contents plus total height at the end.  Empty
+    // until the container is placed.
+    std::vector<int> offsets;
+    std::vector<int> lengths;      // Scratch buffer for computing width.
+    guts::Pos pos;                 // Position of the container.
+    guts::Size size;               // Size of the container.
+    int offset;                    // Number of the top displayed line.
+    int first;                     // First visible item.
+    int last;                      // Item past the last visible one.
+    int changed;                   // First item whose height might differ.
+};
+
+}
+
+#endif // LIBCURSED__SCROLLBOX_HPP__
@@ -18,6 +18,8 @@
 
 #include "Table.hpp"
 
+#include <cstddef>
+
 #include <algorithm>
 #include <functional>
 #include <iomanip>
@@ -28,11 +30,15 @@
 #include <utility>
 #include <vector>
 
+#include "guts/Parallel.hpp"
+
 using namespace cursed;
 using namespace cursed::guts;
 
 static unsigned int measureWidth(const ColorTree &s);
+static unsigned int measureWidth(const Cell &s);
 static unsigned int measurePrefixLength(const ColorTree &s, int prefixWidth);
+static unsigned int measurePrefixLength(const Cell &s, int prefixWidth);
 
 // Helper class that represents single column of a table.
 class Table::Column
@@ -67,17 +73,32 @@ public:
     void clear()
     {
         values.clear();
+        fullWidth = measureWidth(heading);
+        width = fullWidth;
     }
 
     // Adds a value to the column.
-    void append(ColorTree val)
+    void append(Cell val)
+    {
+        const unsigned int valWidth = measureWidth(val);
+        append(std::move(val), valWidth);
+    }
+
+    // Adds a value of known width to the column.
+    void append(Cell val, unsigned int valWidth)
     {
-        fullWidth = std::max(fullWidth, measureWidth(val));
+        fullWidth = std::max(fullWidth, valWidth);
         width = fullWidth;
 
         values.emplace_back(std::move(val));
     }
 
+    // Reserves space for `n` more values.
+    void reserveMore(std::size_t n)
+    {
+        values.reserve(values.size() + n);
+    }
+
     // Retrieves widths of the column.
     unsigned int getWidth() const
     {
@@ -96,11 +117,41 @@ public:
         width -= std::min(width, by);
     }
 
-    // Retrieves printable value of the column by index.  The value can be
-    // truncated to fit limited width, which is indicated by trailing ellipsis.
-    ColorTree operator[](unsigned int i) const
+    // Renders value of the column by index padding or truncating it to fit
+    // column width.  Truncation is indicated by trailing ellipsis.
+    void render(unsigned int i, const Format &hi, std::vector<Run> &runs) const
     {
-        return truncate(values[i]);
+        const Cell &s = values[i];
+
+        unsigned int valueWidth = measureWidth(s);
+        if (valueWidth <= width) {
+            const std::wstring padding(width - valueWidth, L' ');
+            if (!alignLeft) {
+                appendRuns(runs, padding, hi);
+            }
+            appendRuns(runs, s, hi);
+            if (alignLeft) {
+                appendRuns(runs, padding, hi);
+            }
+            return;
+        }
+
+        if (width <= 3U) {
+            appendRuns(runs, std::wstring(L"...").substr(0U, width), hi);
+            return;
+        }
+
+        unsigned int left = measurePrefixLength(s, width - 3U);
+        s.visit([&](const std::wstring &text, const Format &format) {
+            if (left >= text.length()) {
+                runs.emplace_back(text, format);
+                left -= text.length();
+            } else if (left > 0) {
+                runs.emplace_back(text.substr(0, left), format);
+                left = 0;
+            }
+        }, hi);
+        appendRuns(runs, L"...", hi);
     }
 
 private:
@@ -141,23 +192,44 @@ private:
     //! Width of the column.
     unsigned int width;
     //! Contents of the column.
-    std::vector<ColorTree> values;
+    std::vector<Cell> values;
 };
 
 static const std::wstring gap = L"  ";
 
-Table::Table() : maxWidth(0), height(0)
+// Bits of highlight state of cached rows.
+static const int currentState = 1;
+static const int selectedState = 2;
+
+Table::Table() : maxWidth(0), height(0), nItems(0), workers(0)
 {
     currentHi.setReversed(true);
     currentHi.setForeground(Color::Yellow);
+    selectedHi.setBold(true);
+    selectedHi.setForeground(Color::Cyan);
 }
 
 Table::~Table() = default;
 
+// Converts rows of values into rows of cells.
+template <typename T>
+static std::vector<std::vector<Cell>>
+toCells(std::vector<std::vector<T>> rows)
+{
+    std::vector<std::vector<Cell>> cells(rows.size());
+    for (std::size_t i = 0U; i < rows.size(); ++i) {
+        cells[i].reserve(rows[i].size());
+        for (T &value : rows[i]) {
+            cells[i].emplace_back(std::move(value));
+        }
+    }
+    return cells;
+}
+
 void
 Table::addColumn(TableHeader heading)
 {
-    if (!items.empty()) {
+    if (nItems != 0) {
         throw std::invalid_argument("Can't change columns for non-empty "
                                     "table.");
     }
@@ -172,27 +244,87 @@ Table::append(const std::vector<ColorTree> &item)
     if (item.size() != cols.size()) {
         throw std::invalid_argument("Invalid item added to the table.");
     }
-    items.emplace_back(item);
+
+    for (Column &col : cols) {
+        col.append(item[col.getIdx()]);
+    }
+    ++nItems;
 }
 
 void
-Table::removeAll()
+Table::appendPlain(const std::vector<std::string> &item)
 {
-    items.clear();
+    if (item.size() != cols.size()) {
+        throw std::invalid_argument("Invalid item added to the table.");
+    }
+
+    for (Column &col : cols) {
+        col.append(item[col.getIdx()]);
+    }
+    ++nItems;
 }
 
 void
-Table::fillColumns()
+Table::appendRows(std::vector<std::vector<ColorTree>> rows)
 {
-    for (Column &col : cols) {
-        col.clear();
+    appendCells(toCells(std::move(rows)));
+}
+
+void
+Table::appendPlainRows(std::vector<std::vector<std::string>> rows)
+{
+    appendCells(toCells(std::move(rows)));
+}
+
+void
+Table::appendCells(std::vector<std::vector<Cell>> rows)
+{
+    for (const std::vector<Cell> &row : rows) {
+        if (row.size() != cols.size()) {
+            throw std::invalid_argument("Invalid item added to the table.");
+        }
     }
 
-    for (const std::vector<ColorTree> &item : items) {
+    // Widths are measured by chunks of rows in parallel, then they are
+    // combined in order of rows, so the result doesn't depend on scheduling.
+    const std::size_t nCols = cols.size();
+    std::vector<unsigned int> cellWidths(rows.size()*nCols);
+    parallelFor(rows.size(), countChunks(rows.size()*nCols, workers),
+                [&](int /*chunk*/, std::size_t from, std::size_t to) {
+                    for (std::size_t i = from; i < to; ++i) {
+                        for (std::size_t j = 0U; j < nCols; ++j) {
+                            cellWidths[i*nCols + j] = measureWidth(rows[i][j]);
+                        }
+                    }
+                });
+
+    for (Column &col : cols) {
+        col.reserveMore(rows.size());
+    }
+    for (std::size_t i = 0U; i < rows.size(); ++i) {
         for (Column &col : cols) {
-            col.append(item[col.getIdx()]);
+            const int j = col.getIdx();
+            col.append(std::move(rows[i][j]), cellWidths[i*nCols + j]);
         }
     }
+    nItems += rows.size();
+}
+
+void
+Table::setWorkers(int n)
+{
+    workers = n;
+}
+
+void
+Table::removeAll()
+{
+    for (Column &col : cols) {
+        col.clear();
+    }
+    nItems = 0;
+    cache.clear();
+    clearSelection();
 }
 
 bool
@@ -267,10 +399,10 @@ void
 Table::printTableHeader()
 {
     for (Column &col : cols) {
-        win.print(alignCell(col.getHeading(), col));
+        win.print(alignCell(col.getHeading(), col), {}, 0, true);
 
         if (&col != &cols.back()) {
-            win.print(gap);
+            win.print(gap, {}, 0, true);
         }
     }
 }
@@ -279,28 +411,44 @@ void
 Table::printTableRows()
 {
     int top = getTop();
-    int nItems = items.size();
     int pos = getPos();
     for (int i = top; i < top + height - 1; ++i) {
         if (i == nItems) {
             break;
         }
 
-        Format hi;
-        if (i == pos) {
-            hi += currentHi;
+        wmove(win, i - top + 1, 0);
+
+        const int state = (i == pos ? currentState : 0)
+                        | (isSelected(i) ? selectedState : 0);
+        const std::vector<Run> *runs = cache.find(i, state);
+        if (runs == nullptr) {
+            runs = &renderRow(i, state);
         }
+        win.print(*runs, 0, true);
+    }
+}
 
-        wmove(win, i - top + 1, 0);
+const std::vector<Run> &
+Table::renderRow(int i, int state)
+{
+    Format hi;
+    if (state & selectedState) {
+        hi += selectedHi;
+    }
+    if (state & currentState) {
+        hi += currentHi;
+    }
 
-        for (Column &col : cols) {
-            win.print(hi(alignCell(col[i], col)));
+    std::vector<Run> &runs = cache.store(i, state);
+    for (const Column &col : cols) {
+        col.render(i, hi, runs);
 
-            if (&col != &cols.back()) {
-                win.print(hi(gap));
-            }
+        if (&col != &cols.back()) {
+            appendRuns(runs, gap, hi);
         }
     }
+    return runs;
 }
 
 ColorTree
@@ -323,13 +471,22 @@ Table::alignCell(ColorTree s, const Column &col) const
 void
 Table::draw()
 {
-    fillColumns();
-
     if (!adjustColumnsWidths()) {
         // Available width is not enough to display table.
         return;
     }
 
+    // Cached rows are valid only for the same widths of columns.
+    std::vector<unsigned int> newWidths;
+    newWidths.reserve(cols.size());
+    for (const Column &col : cols) {
+        newWidths.push_back(col.getWidth());
+    }
+    if (newWidths != widths) {
+        widths = std::move(newWidths);
+        cache.clear();
+    }
+
     win.erase();
     wmove(win, 0, 0);
 
@@ -356,13 +513,16 @@ Table::placed(Pos newPos, Size newSize)
 {
     WindowWidget::placed(newPos, newSize);
     maxWidth = newSize.cols;
-    height = newSize.lines;
+    if (height != newSize.lines) {
+        height = newSize.lines;
+        cache.resize(height - 1);
+    }
 }
 
 int
 Table::getSize() const
 {
-    return items.size();
+    return nItems;
 }
 
 int
@@ -378,6 +538,13 @@ measureWidth(const ColorTree &s)
     return s.length();
 }
 
+// Calculates width of a cell on the screen.
+static unsigned int
+measureWidth(const Cell &s)
+{
+    return s.length();
+}
+
 // Calculates length of string prefix that takes up specified width on the
 // screen.
 static unsigned int
@@ -385,3 +552,11 @@ measurePrefixLength(const ColorTree &s, int prefixWidth)
 {
     return std::min(s.length(), prefixWidth);
 }
+
+// Calculates length of cell prefix that takes up specified width on the
+// screen.
+static unsigned int
+measurePrefixLength(const Cell &s, int prefixWidth)
+{
+    return std::min(s.length(), prefixWidth);
+}
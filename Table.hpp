@@ -19,8 +19,11 @@
 #ifndef LIBCURSED__TABLE_HPP__
 #define LIBCURSED__TABLE_HPP__
 
+#include <string>
 #include <vector>
 
+#include "guts/Cell.hpp"
+#include "guts/RowCache.hpp"
 #include "guts/WindowWidget.hpp"
 #include "ColorTree.hpp"
 #include "ListLike.hpp"
@@ -62,15 +65,30 @@ public:
     // Adds a row.  Throws std::invalid_argument if item length doesn't match
     // columns.
     void append(const std::vector<ColorTree> &item);
+    // Adds multiple rows at once measuring them in parallel.  Throws
+    // std::invalid_argument if length of any item doesn't match columns, in
+    // which case no rows are added.
+    void appendRows(std::vector<std::vector<ColorTree>> rows);
+    // Adds a row of plain text in UTF-8.  Values of such rows are stored as
+    // strings without allocating a tree per value.  Throws
+    // std::invalid_argument if item length doesn't match columns.
+    void appendPlain(const std::vector<std::string> &item);
+    // Adds multiple rows of plain text at once.  See `appendRows()` and
+    // `appendPlain()`.
+    void appendPlainRows(std::vector<std::vector<std::string>> rows);
     // Removes all rows.
     void removeAll();
 
+    // Sets maximum number of threads for processing large number of rows.
+    // Zero means number of hardware threads, one disables parallelism.
+    void setWorkers(int n);
+
     // Retrieves number of elements in the list.
     virtual int getSize() const override;
 
 private:
-    // Populates columns with items' data.
-    void fillColumns();
+    // Adds multiple rows at once measuring them in parallel.
+    void appendCells(std::vector<std::vector<guts::Cell>> rows);
     // Ensures that columns fit into required width limit.  Returns `true` on
     // successful shrinking.
     bool adjustColumnsWidths();
@@ -78,6 +96,8 @@ private:
     void printTableHeader();
     // Prints table lines.
     void printTableRows();
+    // Renders row of the table into the cache.  Returns rendered runs.
+    const std::vector<guts::Run> & renderRow(int i, int state);
     // Pads string to align it according to column parameters.
     ColorTree alignCell(ColorTree s, const Column &col) const;
 
@@ -106,10 +126,18 @@ private:
     int height;
     // List of columns of the table.
     std::vector<Column> cols;
-    // List of items to display.
-    std::vector<std::vector<ColorTree>> items;
+    // Number of items to display.
+    int nItems;
     // Visual style of the current item.
     Format currentHi;
+    // Visual style of selected items.
+    Format selectedHi;
+    // Widths of columns for which rows were cached.
+    std::vector<unsigned int> widths;
+    // Rendered rows.
+    guts::RowCache cache;
+    // Maximum number of threads to use for bulk processing.
+    int workers;
 };
 
 }
@@ -18,81 +18,778 @@
 
 #include "Text.hpp"
 
+#include <cstddef>
+
+#include <algorithm>
+#include <limits>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include "guts/Matcher.hpp"
+#include "guts/Parallel.hpp"
+#include "guts/RowCache.hpp"
+#include "guts/WrapCache.hpp"
+#include "Highlighter.hpp"
+#include "TextSource.hpp"
+#include "utils.hpp"
+
 using namespace cursed;
 using namespace cursed::guts;
 
-Text::Text() : top(0), height(0)
-{ }
+static std::string cellToUtf8(const Cell &cell);
+
+Text::Text()
+    : maxLines(0), follow(false), source(nullptr), top(0), height(0),
+      width(0), columnOffset(0), wrap(false), topRow(0), bottom(0),
+      bottomRow(0), bottomLines(-1), highlighter(nullptr), statesKnown(0),
+      statesValid(0), statesDirtyEnd(0), searched(0), workers(0)
+{
+    matchHi.setReversed(true);
+}
+
+Text::~Text() = default;
 
 int
 Text::getHeight() const
 { return height; }
 
+// Converts values into cells.
+template <typename T>
+static std::vector<Cell>
+toCells(std::vector<T> values)
+{
+    std::vector<Cell> cells;
+    cells.reserve(values.size());
+    for (T &value : values) {
+        cells.emplace_back(std::move(value));
+    }
+    return cells;
+}
+
 void
 Text::setLines(std::vector<ColorTree> newLines)
 {
-    lines = std::move(newLines);
+    setCells(toCells(std::move(newLines)));
+}
+
+void
+Text::setPlainLines(std::vector<std::string> newLines)
+{
+    setCells(toCells(std::move(newLines)));
+}
+
+void
+Text::setCells(std::vector<Cell> cells)
+{
+    lines.clear();
+    lines.insert(0, std::move(cells));
+    source = nullptr;
+    wraps.clear();
+    bottomLines = -1;
+    resetHighlighting();
+    restartSearch();
+    scrollToTop();
+    applyMaxLines();
+}
+
+void
+Text::setLine(int i, ColorTree newLine)
+{
+    TextLine &line = lines[i];
+    line.cell = std::move(newLine);
+    line.shadow.reset();
+    lineChanged(i);
+}
+
+void
+Text::setPlainLine(int i, std::string newLine)
+{
+    TextLine &line = lines[i];
+    line.cell = std::move(newLine);
+    line.shadow.reset();
+    lineChanged(i);
+}
+
+void
+Text::insertLines(int at, std::vector<ColorTree> newLines)
+{
+    replaceCells(at, 0, toCells(std::move(newLines)));
+}
+
+void
+Text::insertPlainLines(int at, std::vector<std::string> newLines)
+{
+    replaceCells(at, 0, toCells(std::move(newLines)));
+}
+
+void
+Text::eraseLines(int from, int count)
+{
+    replaceCells(from, count, {});
+}
+
+void
+Text::replaceLines(int from, int count, std::vector<ColorTree> newLines)
+{
+    replaceCells(from, count, toCells(std::move(newLines)));
+}
+
+void
+Text::replacePlainLines(int from, int count,
+                        std::vector<std::string> newLines)
+{
+    replaceCells(from, count, toCells(std::move(newLines)));
+}
+
+void
+Text::replaceCells(int from, int count, std::vector<Cell> cells)
+{
+    const int n = cells.size();
+    lines.erase(from, count);
+    lines.insert(from, std::move(cells));
+    linesReplaced(from, count, n);
+    applyMaxLines();
+}
+
+void
+Text::setSource(TextSource *newSource)
+{
+    source = newSource;
+    wraps.clear();
+    bottomLines = -1;
+    resetHighlighting();
+    restartSearch();
     scrollToTop();
 }
 
+void
+Text::appendLines(std::vector<ColorTree> newLines)
+{
+    appendCells(toCells(std::move(newLines)));
+}
+
+void
+Text::appendPlainLines(std::vector<std::string> newLines)
+{
+    appendCells(toCells(std::move(newLines)));
+}
+
+void
+Text::appendCells(std::vector<Cell> cells)
+{
+    lines.insert(lines.size(), std::move(cells));
+    bottomLines = -1;
+    applyMaxLines();
+}
+
+void
+Text::setMaxLines(int n)
+{
+    maxLines = std::max(0, n);
+    applyMaxLines();
+}
+
+void
+Text::setHighlighter(Highlighter *newHighlighter)
+{
+    highlighter = newHighlighter;
+    resetHighlighting();
+}
+
+void
+Text::setFollow(bool enabled)
+{
+    follow = enabled;
+}
+
+void
+Text::setWrap(bool enabled)
+{
+    wrap = enabled;
+    topRow = 0;
+}
+
+int
+Text::estimateRowCount()
+{
+    const int nLines = getLineCount();
+    return (wrap ? wraps.estimateRows(nLines) : nLines);
+}
+
+int
+Text::estimateTopRow()
+{
+    return (wrap ? wraps.estimateRows(top) + topRow : top);
+}
+
+void
+Text::applyMaxLines()
+{
+    const int extra = lines.size() - maxLines;
+    if (maxLines == 0 || extra <= 0) {
+        return;
+    }
+
+    // Dropping the oldest lines keeps displaying the same lines.
+    lines.eraseFront(extra);
+    linesReplaced(0, extra, 0);
+}
+
+void
+Text::linesReplaced(int from, int count, int n)
+{
+    if (source != nullptr) {
+        return;
+    }
+
+    // Cached data of lines outside of the changed range stays valid.
+    wraps.shift(from, count, n);
+    bottomLines = -1;
+    highlighted.shift(from, count, n);
+    matchesReplaced(from, count, n);
+
+    // Keep displaying the same lines if they weren't affected.
+    if (top >= from + count) {
+        top += n - count;
+    } else if (top > from || (top == from && count > 0)) {
+        top = from;
+        topRow = 0;
+    }
+    if (top >= lines.size()) {
+        scrollToBottom();
+    }
+
+    if (from >= statesKnown) {
+        return;
+    }
+
+    // States are stored along with lines and move with them.  Entry state of
+    // the first changed line is recomputed from the line before it, states
+    // of new lines are unknown and the old state of the line after them is
+    // kept for comparison.
+    statesKnown = (from + count < statesKnown ? statesKnown + n - count
+                                              : from);
+    if (statesDirtyEnd > from + count) {
+        statesDirtyEnd += n - count;
+    }
+    statesDirtyEnd = std::max(statesDirtyEnd, from + n);
+    statesValid = std::min(statesValid, from);
+}
+
+void
+Text::lineChanged(int i)
+{
+    if (source != nullptr) {
+        return;
+    }
+
+    wraps.invalidate(i);
+    bottomLines = -1;
+    highlighted.invalidate(i);
+    matchesReplaced(i, 1, 1);
+
+    // States of lines up to this one are still valid and so can be the states
+    // after it unless the change affects them.
+    statesValid = std::min(statesValid, i + 1);
+    statesDirtyEnd = std::max(statesDirtyEnd, i + 1);
+}
+
+void
+Text::resetHighlighting()
+{
+    sourceStates.clear();
+    statesKnown = 0;
+    statesValid = 0;
+    statesDirtyEnd = 0;
+    highlighted.clear();
+}
+
+int
+Text::getEntryState(int i)
+{
+    if (statesValid == 0) {
+        entryState(0) = highlighter->getInitialState();
+        statesValid = 1;
+        statesKnown = std::max(statesKnown, 1);
+    }
+
+    while (statesValid <= i) {
+        const int line = statesValid - 1;
+        int state = entryState(line);
+        highlighter->highlight(getLineText(line), state);
+        recordExitState(line, state);
+    }
+
+    return entryState(i);
+}
+
+void
+Text::recordExitState(int i, int state)
+{
+    // Only the first line with unknown exit state can be recorded.
+    const int next = i + 1;
+    if (next != statesValid || next == getLineCount()) {
+        return;
+    }
+
+    if (next == statesKnown) {
+        entryState(next) = state;
+        statesValid = ++statesKnown;
+        return;
+    }
+
+    // Once state after all changed lines matches the old one, the rest of old
+    // states are correct.
+    if (entryState(next) == state && next >= statesDirtyEnd) {
+        statesValid = statesKnown;
+        statesDirtyEnd = 0;
+        return;
+    }
+
+    entryState(next) = state;
+    statesValid = next + 1;
+}
+
+int &
+Text::entryState(int i)
+{
+    if (source == nullptr) {
+        return lines[i].state;
+    }
+
+    if (i >= static_cast<int>(sourceStates.size())) {
+        sourceStates.resize(i + 1);
+    }
+    return sourceStates[i];
+}
+
+std::wstring
+Text::getLineText(int i)
+{
+    if (source != nullptr) {
+        return fromUtf8(source->getPlainLine(i));
+    }
+
+    const Cell &cell = getOwnLine(i);
+    if (cell.isPlain()) {
+        return fromUtf8(cell.getPlain());
+    }
+
+    std::wstring text;
+    cell.visit([&text](const std::wstring &piece, const Format &/*format*/) {
+        text += piece;
+    });
+    return text;
+}
+
 void
 Text::scrollToTop()
 {
     top = 0;
+    topRow = 0;
 }
 
 void
 Text::scrollToBottom()
 {
-    top = static_cast<int>(lines.size()) - height;
-    if (top < 0) {
-        top = 0;
+    const int nLines = getLineCount();
+
+    if (!wrap) {
+        top = nLines - height;
+        if (top < 0) {
+            top = 0;
+        }
+        return;
     }
+
+    findBottom();
+    top = bottom;
+    topRow = bottomRow;
+}
+
+void
+Text::findBottom()
+{
+    const int nLines = getLineCount();
+    if (bottomLines == nLines) {
+        return;
+    }
+    bottomLines = nLines;
+
+    // Only lines that end up on the screen need to be wrapped.
+    int rowsLeft = height;
+    for (int i = nLines - 1; i >= 0 && rowsLeft > 0; --i) {
+        const int nRows = getRowCount(i);
+        if (nRows >= rowsLeft) {
+            bottom = i;
+            bottomRow = nRows - rowsLeft;
+            return;
+        }
+        rowsLeft -= nRows;
+    }
+
+    bottom = 0;
+    bottomRow = 0;
 }
 
 void
 Text::scrollDown()
 {
-    ++top;
-    if (top > static_cast<int>(lines.size()) - height) {
-        top = static_cast<int>(lines.size()) - height;
-        if (top < 0) {
-            top = 0;
+    const int nLines = getLineCount();
+
+    if (!wrap) {
+        ++top;
+        if (top > nLines - height) {
+            top = nLines - height;
+            if (top < 0) {
+                top = 0;
+            }
         }
+        return;
+    }
+
+    if (top < nLines && topRow + 1 < getRowCount(top)) {
+        ++topRow;
+    } else if (top + 1 < nLines) {
+        ++top;
+        topRow = 0;
+    }
+
+    // Don't scroll past the position at which the last row is at the bottom.
+    findBottom();
+    if (top > bottom || (top == bottom && topRow > bottomRow)) {
+        top = bottom;
+        topRow = bottomRow;
     }
 }
 
 void
 Text::scrollUp()
 {
+    if (wrap && topRow > 0) {
+        --topRow;
+        return;
+    }
+
     --top;
     if (top < 0) {
         top = 0;
+    } else if (wrap) {
+        topRow = getRowCount(top) - 1;
+    }
+}
+
+void
+Text::scrollLeft()
+{
+    setColumnOffset(columnOffset - 1);
+}
+
+void
+Text::scrollRight()
+{
+    setColumnOffset(columnOffset + 1);
+}
+
+void
+Text::setColumnOffset(int offset)
+{
+    columnOffset = std::max(0, offset);
+}
+
+int
+Text::getColumnOffset() const
+{
+    return columnOffset;
+}
+
+void
+Text::search(const std::wstring &pattern, bool regex)
+{
+    startSearch(pattern, regex);
+    while (continueSearch(std::numeric_limits<int>::max())) {
+        // Source can grow while we're searching.
+    }
+}
+
+void
+Text::startSearch(const std::wstring &pattern, bool regex)
+{
+    matcher.reset(new Matcher(pattern, regex));
+    restartSearch();
+}
+
+bool
+Text::continueSearch(int nLines)
+{
+    if (matcher == nullptr) {
+        return false;
+    }
+
+    const int nTotal = getLineCount();
+    const int first = searched;
+    const int count = std::max(0, std::min(nTotal - first, nLines));
+
+    std::vector<TextMatch> found = searchLines(first, count);
+    matches.insert(matches.end(), found.cbegin(), found.cend());
+
+    searched = first + count;
+    return (searched < nTotal);
+}
+
+std::vector<TextMatch>
+Text::searchLines(int first, int count)
+{
+    // Lines are searched by chunks in parallel and then matches of chunks are
+    // combined in order of lines.
+    const int nChunks = countChunks(count, workers);
+    std::vector<std::vector<TextMatch>> found(nChunks);
+    parallelFor(count, nChunks,
+                [&](int chunk, std::size_t from, std::size_t to) {
+                    std::string buf;
+                    std::vector<MatchPos> positions;
+                    for (std::size_t i = from; i < to; ++i) {
+                        const int line = first + i;
+                        positions.clear();
+                        matcher->findAll(getSearchText(line, buf),
+                                         positions);
+                        for (const MatchPos &pos : positions) {
+                            found[chunk].push_back({ line, pos.col, pos.len });
+                        }
+                    }
+                });
+
+    std::vector<TextMatch> result;
+    for (const std::vector<TextMatch> &chunkMatches : found) {
+        result.insert(result.end(), chunkMatches.cbegin(),
+                      chunkMatches.cend());
     }
+    return result;
+}
+
+const std::vector<TextMatch> &
+Text::getMatches() const
+{
+    return matches;
+}
+
+void
+Text::clearSearch()
+{
+    matcher.reset();
+    restartSearch();
+}
+
+void
+Text::setWorkers(int n)
+{
+    workers = n;
+}
+
+void
+Text::restartSearch()
+{
+    searched = 0;
+    matches.clear();
+}
+
+void
+Text::matchesReplaced(int from, int count, int n)
+{
+    if (from >= searched) {
+        return;
+    }
+
+    auto byLine = [](const TextMatch &m, int line) { return m.line < line; };
+    auto first = std::lower_bound(matches.begin(), matches.end(), from,
+                                  byLine);
+    auto last = std::lower_bound(first, matches.end(), from + count, byLine);
+
+    // Search stops before the changed lines if it hasn't passed them yet.
+    if (searched < from + count) {
+        matches.erase(first, matches.end());
+        searched = from;
+        return;
+    }
+
+    for (auto it = last; it != matches.end(); ++it) {
+        it->line += n - count;
+    }
+    searched += n - count;
+
+    // Only new lines need to be searched.
+    std::vector<TextMatch> found = searchLines(from, n);
+    first = matches.erase(first, last);
+    matches.insert(first, found.cbegin(), found.cend());
+}
+
+const std::string &
+Text::getSearchText(int i, std::string &buf)
+{
+    if (source != nullptr) {
+        buf = source->getPlainLine(i);
+        return buf;
+    }
+
+    TextLine &line = lines[i];
+    if (line.cell.isPlain()) {
+        return line.cell.getPlain();
+    }
+
+    if (line.shadow == nullptr) {
+        line.shadow.reset(new std::string(cellToUtf8(line.cell)));
+    }
+    return *line.shadow;
 }
 
 void
 Text::draw()
 {
+    if (follow) {
+        scrollToBottom();
+    }
+
     win.erase();
+    if (wrap) {
+        drawWrapped();
+        wnoutrefresh(win);
+        return;
+    }
+
+    const int nLines = getLineCount();
     int line = 0;
     for (int i = top; i < top + height; ++i, ++line) {
-        if (i == static_cast<int>(lines.size())) {
+        if (i == nLines) {
             break;
         }
 
         wmove(win, line, 0);
         wclrtoeol(win);
         wmove(win, line, 1);
-        win.print(lines[i]);
+        printLine(i);
     }
     wnoutrefresh(win);
 }
 
+void
+Text::drawWrapped()
+{
+    const int nLines = getLineCount();
+    std::vector<Run> runs;
+
+    int row = 0;
+    for (int i = top; i < nLines && row < height; ++i) {
+        runs.clear();
+        buildRuns(i, runs);
+
+        // Highlighting doesn't change text, so wrap points can be found using
+        // the same runs.
+        const std::vector<int> *points = wraps.find(i);
+        if (points == nullptr) {
+            points = &wraps.store(i, findWrapPoints(runs, wraps.getWidth()));
+        }
+
+        // Number of rows of the top line can shrink after a resize.
+        const int nRows = points->size() + 1;
+        if (i == top && topRow >= nRows) {
+            topRow = nRows - 1;
+        }
+
+        for (int r = (i == top ? topRow : 0); r < nRows && row < height; ++r) {
+            const int from = (r == 0 ? 0 : (*points)[r - 1]);
+            const int to = (r == nRows - 1 ? std::numeric_limits<int>::max()
+                                           : (*points)[r]);
+            wmove(win, row++, 1);
+            win.print(sliceRuns(runs, from, to - from), 0, true);
+        }
+    }
+}
+
+void
+Text::printLine(int i)
+{
+    auto byLine = [](const TextMatch &m, int line) { return m.line < line; };
+    auto it = std::lower_bound(matches.cbegin(), matches.cend(), i, byLine);
+    if (highlighter == nullptr && (it == matches.cend() || it->line != i)) {
+        if (source != nullptr) {
+            win.print(source->getLine(i), {}, columnOffset, true);
+        } else {
+            win.print(getOwnLine(i), {}, columnOffset, true);
+        }
+        return;
+    }
+
+    std::vector<Run> runs;
+    buildRuns(i, runs);
+    win.print(runs, columnOffset, true);
+}
+
+void
+Text::buildRuns(int i, std::vector<Run> &runs)
+{
+    if (highlighter != nullptr) {
+        // Highlighted lines are cached along with state they were highlighted
+        // in, which makes lines whose entry state has changed miss the cache.
+        const int state = getEntryState(i);
+        const std::vector<Run> *cached = highlighted.find(i, state);
+        if (cached == nullptr) {
+            int exitState = state;
+            ColorTree tree = highlighter->highlight(getLineText(i), exitState);
+            recordExitState(i, exitState);
+
+            std::vector<Run> &stored = highlighted.store(i, state);
+            appendRuns(stored, tree);
+            cached = &stored;
+        }
+        runs.insert(runs.end(), cached->cbegin(), cached->cend());
+    } else if (source != nullptr) {
+        appendRuns(runs, source->getLine(i));
+    } else {
+        appendRuns(runs, getOwnLine(i));
+    }
+
+    auto byLine = [](const TextMatch &m, int line) { return m.line < line; };
+    auto it = std::lower_bound(matches.cbegin(), matches.cend(), i, byLine);
+    for (; it != matches.cend() && it->line == i; ++it) {
+        highlightRuns(runs, it->col, it->length, matchHi);
+    }
+}
+
+const std::vector<int> &
+Text::getWrapPoints(int i)
+{
+    if (const std::vector<int> *points = wraps.find(i)) {
+        return *points;
+    }
+
+    std::vector<Run> runs;
+    if (source != nullptr) {
+        appendRuns(runs, source->getLine(i));
+    } else {
+        appendRuns(runs, getOwnLine(i));
+    }
+    return wraps.store(i, findWrapPoints(runs, wraps.getWidth()));
+}
+
+int
+Text::getRowCount(int i)
+{
+    return getWrapPoints(i).size() + 1;
+}
+
+int
+Text::getLineCount() const
+{
+    return (source != nullptr ? source->getLineCount() : lines.size());
+}
+
+const Cell &
+Text::getOwnLine(int i) const
+{
+    return lines[i].cell;
+}
+
 int
 Text::desiredHeight()
 {
@@ -109,5 +806,24 @@ void
 Text::placed(Pos newPos, Size newSize)
 {
     WindowWidget::placed(newPos, newSize);
-    height = newSize.lines;
+    if (height != newSize.lines) {
+        height = newSize.lines;
+        // Keep wrap points of lines on the screen and around it.
+        wraps.resize(4*height);
+        highlighted.resize(height);
+        bottomLines = -1;
+    }
+    if (width != newSize.cols) {
+        width = newSize.cols;
+        bottomLines = -1;
+    }
+    // The first column is left empty.
+    wraps.setWidth(std::max(1, width - 1));
+}
+
+// Converts text of a cell to UTF-8.
+static std::string
+cellToUtf8(const Cell &cell)
+{
+    return (cell.isPlain() ? cell.getPlain() : cell.getTree().toUtf8());
 }
@@ -19,20 +19,42 @@
 #ifndef LIBCURSED__TEXT_HPP__
 #define LIBCURSED__TEXT_HPP__
 
+#include <memory>
 #include <string>
 #include <vector>
 
+#include "guts/Cell.hpp"
+#include "guts/LineRope.hpp"
+#include "guts/RowCache.hpp"
 #include "guts/WindowWidget.hpp"
+#include "guts/WrapCache.hpp"
 #include "ColorTree.hpp"
 
 namespace cursed {
 
+namespace guts {
+    class Matcher;
+}
+
+class Highlighter;
+class TextSource;
+
+// Position of a search match in text.
+struct TextMatch
+{
+    int line;   // Index of the line.
+    int col;    // Offset of the match in characters.
+    int length; // Length of the match in characters.
+};
+
 // A scrollable widget for displaying static text.
 class Text : public guts::WindowWidget
 {
 public:
     // Constructs an empty text widget.  Can throw `std::runtime_error`.
     explicit Text();
+    // Emit destructing code in corresponding source file.
+    ~Text();
 
     Text(const Text &rhs) = delete;
     Text(Text &&rhs) = delete;
@@ -45,18 +67,157 @@ public:
 
     // Assigns list of lines.
     void setLines(std::vector<ColorTree> newLines);
+    // Assigns list of plain lines in UTF-8.  Such lines are stored as strings
+    // without allocating a tree per line.
+    void setPlainLines(std::vector<std::string> newLines);
+    // Updates own line at position (should be a valid index).
+    void setLine(int i, ColorTree newLine);
+    // Updates own line at position (should be a valid index) with plain text
+    // in UTF-8.
+    void setPlainLine(int i, std::string newLine);
+
+    // Inserts lines before own line at position `at` (which can be equal to
+    // number of lines).  View stays on the same lines if possible.
+    void insertLines(int at, std::vector<ColorTree> newLines);
+    // Inserts plain lines in UTF-8 before own line at position `at` (which can
+    // be equal to number of lines).
+    void insertPlainLines(int at, std::vector<std::string> newLines);
+    // Removes `count` own lines starting at `from` (should be a valid range).
+    void eraseLines(int from, int count);
+    // Replaces `count` own lines starting at `from` (should be a valid range)
+    // with new lines.
+    void replaceLines(int from, int count, std::vector<ColorTree> newLines);
+    // Replaces `count` own lines starting at `from` (should be a valid range)
+    // with plain lines in UTF-8.
+    void replacePlainLines(int from, int count,
+                           std::vector<std::string> newLines);
+    // Makes the widget display lines of the source, which must outlive its use
+    // by the widget.  `nullptr` or a call to `set*Lines()` makes the widget
+    // display its own lines.
+    void setSource(TextSource *newSource);
+
+    // Appends lines to own lines of the widget.  Oldest lines are dropped if
+    // their number exceeds limit.
+    void appendLines(std::vector<ColorTree> newLines);
+    // Appends plain lines in UTF-8 to own lines of the widget.  Oldest lines
+    // are dropped if their number exceeds limit.
+    void appendPlainLines(std::vector<std::string> newLines);
+    // Sets maximum number of own lines to keep (zero or negative means no
+    // limit).  Oldest lines are dropped to fit within the limit.
+    void setMaxLines(int n);
+
+    // Makes the widget format text of lines by the highlighter, which must
+    // outlive its use by the widget.  `nullptr` disables highlighting.
+    void setHighlighter(Highlighter *newHighlighter);
+
+    // Sets whether view is kept at the bottom of the text.  While this mode is
+    // on, scroll position is updated on each draw.
+    void setFollow(bool enabled);
+    // Sets whether lines that don't fit are wrapped instead of being cut off.
+    // Scrolling is done by screen rows while this mode is on.
+    void setWrap(bool enabled);
+
+    // Estimates number of screen rows text takes up, which is exact unless
+    // lines are wrapped.  Meant for positioning scroll bars.
+    int estimateRowCount();
+    // Estimates index of the first visible screen row in the same units as
+    // `estimateRowCount()`.
+    int estimateTopRow();
 
     // Scrolls all the way up.
     void scrollToTop();
     // Scrolls all the way down.
     void scrollToBottom();
 
-    // Scrolls text one line down.
+    // Scrolls text one line (screen row when wrapping) down.
     void scrollDown();
-    // Scrolls text one line up.
+    // Scrolls text one line (screen row when wrapping) up.
     void scrollUp();
 
+    // Scrolls text one screen column left.
+    void scrollLeft();
+    // Scrolls text one screen column right.
+    void scrollRight();
+    // Sets how many leading screen columns of lines are hidden.  Has no effect
+    // while lines are wrapped.
+    void setColumnOffset(int offset);
+    // Retrieves how many leading screen columns of lines are hidden.
+    int getColumnOffset() const;
+
+    // Searches for all matches of a pattern, which is either a substring or an
+    // ECMAScript regular expression.  Matches are highlighted on drawing.
+    // Throws `std::regex_error` on invalid regular expression.
+    void search(const std::wstring &pattern, bool regex = false);
+    // Starts search that will be performed by `continueSearch()`.  Throws
+    // `std::regex_error` on invalid regular expression.
+    void startSearch(const std::wstring &pattern, bool regex = false);
+    // Searches next `nLines` lines.  Returns `true` if there are more lines to
+    // search.
+    bool continueSearch(int nLines);
+    // Retrieves matches found so far ordered by their position.
+    const std::vector<TextMatch> & getMatches() const;
+    // Stops search and forgets its matches.
+    void clearSearch();
+
+    // Sets maximum number of threads for searching.  Zero means number of
+    // hardware threads, one disables parallelism.  Sources of lines must
+    // support concurrent calls of `getPlainLine()` for parallel search.
+    void setWorkers(int n);
+
 private:
+    // Retrieves number of lines to display.
+    int getLineCount() const;
+    // Retrieves own line by its index (should be a valid one).
+    const guts::Cell & getOwnLine(int i) const;
+    // Replaces all own lines.
+    void setCells(std::vector<guts::Cell> cells);
+    // Replaces range of own lines with new ones.
+    void replaceCells(int from, int count, std::vector<guts::Cell> cells);
+    // Adds own lines after the last one.
+    void appendCells(std::vector<guts::Cell> cells);
+    // Drops oldest own lines to fit within the limit.
+    void applyMaxLines();
+    // Updates state after `count` own lines starting at `from` were replaced
+    // with `n` lines.
+    void linesReplaced(int from, int count, int n);
+    // Updates caches after own line has changed.
+    void lineChanged(int i);
+    // Forgets results of highlighting.
+    void resetHighlighting();
+    // Retrieves highlighter state at the start of a line processing lines
+    // before it if necessary.
+    int getEntryState(int i);
+    // Remembers highlighter state at the end of a line if it's the one after
+    // the last valid state.
+    void recordExitState(int i, int state);
+    // Retrieves storage of highlighter state at the start of a line.
+    int & entryState(int i);
+    // Retrieves text of a line without formatting.
+    std::wstring getLineText(int i);
+    // Makes search start over.
+    void restartSearch();
+    // Searches `count` lines starting at `first` and returns their matches.
+    std::vector<TextMatch> searchLines(int first, int count);
+    // Updates matches and search progress after `count` own lines starting at
+    // `from` were replaced with `n` lines.
+    void matchesReplaced(int from, int count, int n);
+    // Retrieves text of a line for searching in UTF-8.  `buf` is used for
+    // text that isn't stored.
+    const std::string & getSearchText(int i, std::string &buf);
+    // Prints a line highlighting search matches in it.
+    void printLine(int i);
+    // Builds runs of a line highlighting search matches in it.
+    void buildRuns(int i, std::vector<guts::Run> &runs);
+    // Computes position at which the last row of wrapped text is at the
+    // bottom of the screen unless it's already known.
+    void findBottom();
+    // Retrieves wrap points of a line for current width.
+    const std::vector<int> & getWrapPoints(int i);
+    // Retrieves number of screen rows a line takes up when wrapped.
+    int getRowCount(int i);
+    // Draws lines wrapping them.
+    void drawWrapped();
+
     // Updates state of this widget to be published on the screen.
     virtual void draw() override;
 
@@ -73,9 +234,34 @@ private:
     virtual void placed(guts::Pos newPos, guts::Size newSize) override;
 
 private:
-    std::vector<ColorTree> lines; // Text itself.
-    int top;                      // First element to display.
-    int height;                   // Screen height.
+    guts::LineRope lines;          // Text itself.
+    int maxLines;                  // Maximum number of lines or zero.
+    bool follow;                   // Whether view follows end of text.
+    TextSource *source;            // Source of text or `nullptr`.
+    int top;                       // First element to display.
+    int height;                    // Screen height.
+    int width;                     // Screen width.
+    int columnOffset;              // Number of hidden leading columns.
+
+    bool wrap;             // Whether long lines are wrapped.
+    int topRow;            // First row of `top` line to display when wrapping.
+    int bottom;            // Last value of `top` when wrapping.
+    int bottomRow;         // Last value of `topRow` for `bottom` line.
+    int bottomLines;       // Number of lines `bottom` is valid for or -1.
+    guts::WrapCache wraps; // Wrap points of lines around the view.
+
+    Highlighter *highlighter;      // Highlighter of lines or `nullptr`.
+    std::vector<int> sourceStates; // States at starts of lines of the source.
+    int statesKnown;               // Number of leading lines with states.
+    int statesValid;               // Number of leading valid states.
+    int statesDirtyEnd;            // Index past the last changed line.
+    guts::RowCache highlighted;    // Highlighted lines around the view.
+
+    std::unique_ptr<guts::Matcher> matcher; // Active search or `nullptr`.
+    int searched;                           // Number of searched lines.
+    std::vector<TextMatch> matches;         // Matches found so far.
+    Format matchHi;                         // Visual style of search matches.
+    int workers;                            // Maximum number of threads.
 };
 
 }
@@ -0,0 +1,52 @@
+// libcursed -- C++ classes for dealing with curses
+// Copyright (C) 2022 xaizek <xaizek@posteo.net>
+//
+// This file is part of libcursed.
+//
+// libcursed is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// libcursed is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with libcursed.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef LIBCURSED__TEXTSOURCE_HPP__
+#define LIBCURSED__TEXTSOURCE_HPP__
+
+#include <string>
+
+#include "ColorTree.hpp"
+
+namespace cursed {
+
+// Provider of lines for `Text` widget which produces them on demand.  Only
+// lines that are displayed are requested.
+class TextSource
+{
+protected:
+    // No base class destruction.
+    ~TextSource() = default;
+
+public:
+    // Retrieves number of lines that are available at the moment.  The number
+    // can grow over time.
+    virtual int getLineCount() = 0;
+    // Retrieves line by its index (should be a valid one).
+    virtual ColorTree getLine(int i) = 0;
+    // Retrieves text of a line without formatting in UTF-8.  Used for
+    // searching, which can call it from multiple threads simultaneously.
+    virtual std::string getPlainLine(int i)
+    {
+        return getLine(i).toUtf8();
+    }
+};
+
+}
+
+#endif // LIBCURSED__TEXTSOURCE_HPP__
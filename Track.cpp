@@ -21,29 +21,38 @@
 #include <algorithm>
 #include <vector>
 
+#include "guts/Layout.hpp"
 #include "guts/Pos.hpp"
 #include "guts/Size.hpp"
 
 using namespace cursed;
 using namespace cursed::guts;
 
-static std::vector<int> doLayout(std::vector<int> lengths, int max);
-static int calculateDesired(const std::vector<int> &lengths);
-
-// Boundary to narrow range of values to avoid integer overflows.
-constexpr int Range = 10000;
+Flex::Flex(int weight, int min, int max)
+    : weight(std::max(weight, 0)), min(std::max(min, 0)),
+      max(max < 0 ? -1 : std::max(max, this->min))
+{ }
 
 Track::Track(Orientation orientation) : orientation(orientation)
 { }
 
 void
 Track::addItem(Widget *w)
+{
+    addItem(w, Flex(0));
+}
+
+void
+Track::addItem(Widget *w, Flex flex)
 {
     widgets.push_back(w);
+    flexes.push_back(flex);
+    w->setParent(this);
+    invalidateSize();
 }
 
 void
-Track::place(Pos newPos, Size newSize)
+Track::placed(Pos newPos, Size newSize)
 {
     if (orientation == Orientation::Vertical) {
         placeVertically(newPos, newSize);
@@ -55,141 +64,61 @@ Track::place(Pos newPos, Size newSize)
 void
 Track::placeVertically(Pos newPos, Size newSize)
 {
-    std::vector<int> lengths;
-    lengths.reserve(widgets.size());
-    for (Widget *w : widgets) {
-        lengths.push_back(w->getDesiredHeight());
+    lengths.clear();
+    for (unsigned int i = 0U; i < widgets.size(); ++i) {
+        lengths.push_back(flexes[i].weight > 0
+                          ? 0
+                          : widgets[i]->getDesiredHeight());
     }
 
-    lengths = doLayout(lengths, newSize.lines);
+    doLayout(lengths, flexes, newSize.lines, layout);
 
     // Apply placement results.
-    for (unsigned int i = 0U; i < lengths.size(); ++i) {
-        widgets[i]->place(newPos, Size(lengths[i], newSize.cols));
-        newPos.y += lengths[i];
+    for (unsigned int i = 0U; i < layout.size(); ++i) {
+        widgets[i]->place(newPos, Size(layout[i], newSize.cols));
+        newPos.y += layout[i];
     }
 }
 
 void
 Track::placeHorizontally(Pos newPos, Size newSize)
 {
-    std::vector<int> lengths;
-    lengths.reserve(widgets.size());
-    for (Widget *w : widgets) {
-        lengths.push_back(w->getDesiredWidth());
+    lengths.clear();
+    for (unsigned int i = 0U; i < widgets.size(); ++i) {
+        lengths.push_back(flexes[i].weight > 0
+                          ? 0
+                          : widgets[i]->getDesiredWidth());
     }
 
-    lengths = doLayout(lengths, newSize.cols);
+    doLayout(lengths, flexes, newSize.cols, layout);
 
     // Apply placement results.
-    for (unsigned int i = 0U; i < lengths.size(); ++i) {
-        widgets[i]->place(newPos, Size(newSize.lines, lengths[i]));
-        newPos.x += lengths[i];
-    }
-}
-
-// Performs distribution of `max` units among widgets that want specified
-// lengths.
-static std::vector<int>
-doLayout(std::vector<int> lengths, int max)
-{
-    int nFlexible = 0;
-    int nFillers = 0;
-    int booked = 0;
-
-    std::vector<int> layout;
-    int lengthLeft = max;
-
-    auto getBooked = [&nFillers](int len) {
-        if (len <= -Range) {
-            ++nFillers;
-            return 1;
-        }
-        return -len;
-    };
-
-    for (int length : lengths) {
-        length = std::max(std::min(length, Range), -Range);
-
-        if (length < 0) {
-            ++nFlexible;
-            booked += getBooked(length);
-            layout.emplace_back();
-        } else {
-            layout.emplace_back(length);
-            lengthLeft = std::max(0, lengthLeft - length);
-        }
-    }
-
-    if (lengthLeft < booked) {
-        int have = lengthLeft;
-        int left = nFlexible;
-        for (unsigned int i = 0U; i < lengths.size(); ++i) {
-            if (lengths[i] < 0) {
-                int length = getBooked(lengths[i]);
-
-                --left;
-                layout[i] = (left == 0)
-                          ? have
-                          : lengthLeft*(float(length)/booked);
-                have -= layout[i];
-            }
-        }
-        return layout;
+    for (unsigned int i = 0U; i < layout.size(); ++i) {
+        widgets[i]->place(newPos, Size(newSize.lines, layout[i]));
+        newPos.x += layout[i];
     }
-
-    if (nFillers > 0) {
-        int slice = (lengthLeft - booked)/nFillers;
-        for (unsigned int i = 0U; i < lengths.size(); ++i) {
-            if (lengths[i] <= -Range) {
-                --nFillers;
-                --nFlexible;
-
-                if (nFillers == 0) {
-                    layout[i] = lengthLeft - booked;
-                    lengthLeft = booked;
-                } else {
-                    layout[i] = slice + 1;
-                    lengthLeft -= slice;
-                }
-
-                lengths[i] = 0;
-            }
-        }
-    }
-
-    // Place flexible items giving them share of extra space.
-    int extraFraction = (nFlexible != 0)
-                      ? (lengthLeft - booked)/nFlexible
-                      : 0;
-    for (unsigned int i = 0U; i < lengths.size(); ++i) {
-        if (lengths[i] < 0) {
-            --nFlexible;
-            layout[i] = (nFlexible == 0)
-                      ? lengthLeft
-                      : std::min(lengthLeft, -lengths[i] + extraFraction);
-            lengthLeft -= layout[i];
-        }
-    }
-
-    return layout;
 }
 
 void
 Track::draw()
 {
     for (Widget *w : widgets) {
-        w->draw();
+        if (!w->isHidden()) {
+            w->draw();
+        }
     }
 }
 
 int
 Track::desiredHeight()
 {
-    std::vector<int> lengths;
-    lengths.reserve(widgets.size());
-    for (Widget *w : widgets) {
-        lengths.push_back(w->getDesiredHeight());
+    const bool vertical = (orientation == Orientation::Vertical);
+
+    lengths.clear();
+    for (unsigned int i = 0U; i < widgets.size(); ++i) {
+        lengths.push_back(vertical && flexes[i].weight > 0
+                          ? getFlexPolicy(flexes[i])
+                          : widgets[i]->getDesiredHeight());
     }
     return calculateDesired(lengths);
 }
@@ -197,28 +126,13 @@ Track::desiredHeight()
 int
 Track::desiredWidth()
 {
-    std::vector<int> lengths;
-    lengths.reserve(widgets.size());
-    for (Widget *w : widgets) {
-        lengths.push_back(w->getDesiredWidth());
-    }
-    return calculateDesired(lengths);
-}
+    const bool horizontal = (orientation == Orientation::Horizontal);
 
-// Calculates desired length of the track based on desired lengths of widgets.
-static int
-calculateDesired(const std::vector<int> &lengths)
-{
-    int minLength = 0;
-    int sign = 1;
-    for (int length : lengths) {
-        length = std::max(std::min(length, Range), -Range);
-        if (length != -Range) {
-            minLength = std::max(minLength, std::abs(length));
-            if (length < 0) {
-                sign = -1;
-            }
-        }
+    lengths.clear();
+    for (unsigned int i = 0U; i < widgets.size(); ++i) {
+        lengths.push_back(horizontal && flexes[i].weight > 0
+                          ? getFlexPolicy(flexes[i])
+                          : widgets[i]->getDesiredWidth());
     }
-    return sign*minLength;
+    return calculateDesired(lengths);
 }
@@ -32,6 +32,19 @@ enum class Orientation
     Vertical    // From top to bottom.
 };
 
+// Layout constraints of a track item that takes a share of free space of the
+// track instead of using its size policy.
+struct Flex
+{
+    // Zero `weight` means that size policy of the item is used.  Negative
+    // `max` means no upper bound.
+    explicit Flex(int weight = 1, int min = 0, int max = -1);
+
+    int weight; // Share of free space relative to other items.
+    int min;    // Minimal length.
+    int max;    // Maximal length or -1.
+};
+
 // Organizes widgets it contains vertically taking their height policy into
 // account.
 class Track : public guts::Widget
@@ -43,12 +56,14 @@ public:
 public:
     // Adds item to this track.
     void addItem(Widget *w);
-
-public:
-    // Performs position and size update.
-    virtual void place(guts::Pos newPos, guts::Size newSize) override;
+    // Adds item to this track with flex constraints.  Free space is divided
+    // among such items proportionally to their weights within their bounds.
+    void addItem(Widget *w, Flex flex);
 
 private:
+    // Notifies widget of new position and size.
+    virtual void placed(guts::Pos newPos, guts::Size newSize) override;
+
     // Performs position and size update for vertical orientation.
     void placeVertically(guts::Pos newPos, guts::Size newSize);
     // Performs position and size update for horizontal orientation.
@@ -69,6 +84,10 @@ private:
 private:
     Orientation orientation;       // Which way to layout widgets.
     std::vector<Widget *> widgets; // Child widgets of this track.
+    std::vector<Flex> flexes;      // Flex constraints of child widgets.
+    // Scratch buffers for layout which keep their capacity between calls.
+    std::vector<int> lengths;      // Size policies of widgets.
+    std::vector<int> layout;       // Computed lengths of widgets.
 };
 
 }
@@ -0,0 +1,93 @@
+// libcursed -- C++ classes for dealing with curses
+// Copyright (C) 2022 xaizek <xaizek@posteo.net>
+//
+// This file is part of libcursed.
+//
+// libcursed is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// libcursed is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with libcursed.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "Cell.hpp"
+
+#include <langinfo.h>
+
+#include <cstring>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../utils.hpp"
+
+using namespace cursed;
+using namespace cursed::guts;
+namespace guts = cursed::guts;
+
+Cell::Cell(const Cell &rhs)
+    : plain(rhs.plain),
+      tree(rhs.tree == nullptr ? nullptr : new ColorTree(*rhs.tree))
+{ }
+
+Cell &
+Cell::operator=(const Cell &rhs)
+{
+    if (this != &rhs) {
+        plain = rhs.plain;
+        tree.reset(rhs.tree == nullptr ? nullptr : new ColorTree(*rhs.tree));
+    }
+    return *this;
+}
+
+int
+Cell::length() const
+{
+    if (tree == nullptr) {
+        return cursed::countUtf8Chars(plain.data(),
+                                      plain.data() + plain.size());
+    }
+    return tree->length();
+}
+
+void
+Cell::visit(const visitorFunc &visitor, const Format &base) const
+{
+    if (tree != nullptr) {
+        tree->visit(visitor, base);
+    } else {
+        visitor(fromUtf8(plain), base);
+    }
+}
+
+bool
+guts::operator==(const Cell &lhs, const Cell &rhs)
+{
+    if (lhs.isPlain() && rhs.isPlain()) {
+        return lhs.getPlain() == rhs.getPlain();
+    }
+
+    using pieces = std::vector<std::pair<std::wstring, Format>>;
+    auto collect = [](const Cell &cell) {
+        pieces result;
+        cell.visit([&result](const std::wstring &text, const Format &format) {
+            result.emplace_back(text, format);
+        });
+        return result;
+    };
+    return collect(lhs) == collect(rhs);
+}
+
+bool
+guts::isUtf8Locale()
+{
+    static const bool utf8 = (std::strcmp(nl_langinfo(CODESET), "UTF-8") == 0);
+    return utf8;
+}
@@ -0,0 +1,92 @@
+// libcursed -- C++ classes for dealing with curses
+// Copyright (C) 2022 xaizek <xaizek@posteo.net>
+//
+// This file is part of libcursed.
+//
+// libcursed is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// libcursed is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with libcursed.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef LIBCURSED__GUTS__CELL_HPP__
+#define LIBCURSED__GUTS__CELL_HPP__
+
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "../ColorTree.hpp"
+
+namespace cursed { namespace guts {
+
+// Compact storage of a piece of displayed data which is either plain text in
+// UTF-8 (same as a tree built out of a narrow string) or a formatted tree.
+// Plain text costs a single narrow string and a null pointer, trees are
+// allocated separately.
+class Cell
+{
+    // Type of callback function invoked for pieces of text on visit.
+    using visitorFunc = std::function<void(const std::wstring &text,
+                                           const Format &format)>;
+
+public:
+    // Constructs an empty plain cell.
+    Cell() = default;
+    // Constructs a plain cell.
+    Cell(std::string plain) : plain(std::move(plain))
+    { }
+    // Constructs a formatted cell.
+    Cell(ColorTree tree) : tree(new ColorTree(std::move(tree)))
+    { }
+
+    // Makes a deep copy.
+    Cell(const Cell &rhs);
+    // Moves data.
+    Cell(Cell &&rhs) = default;
+    // Makes a deep copy.
+    Cell & operator=(const Cell &rhs);
+    // Moves data.
+    Cell & operator=(Cell &&rhs) = default;
+
+public:
+    // Checks whether this is plain text.
+    bool isPlain() const
+    { return tree == nullptr; }
+    // Retrieves plain text.  Should be called only for plain cells.
+    const std::string & getPlain() const
+    { return plain; }
+    // Retrieves tree.  Should be called only for formatted cells.
+    const ColorTree & getTree() const
+    { return *tree; }
+
+    // Retrieves cumulative length of all pieces of text.
+    int length() const;
+
+    // Invokes visitor per piece of text.  `base` format is merged in as if
+    // it wrapped the contents.
+    void visit(const visitorFunc &visitor, const Format &base = {}) const;
+
+private:
+    std::string plain;               // Plain text.
+    std::unique_ptr<ColorTree> tree; // Formatted text or `nullptr`.
+};
+
+// Checks whether two cells display the same formatted text.  Trees that
+// produce the same text split in pieces differently are considered different.
+bool operator==(const Cell &lhs, const Cell &rhs);
+
+// Checks whether multibyte encoding of current locale is UTF-8.  The check is
+// done once, locale is expected to be set up before the library is used.
+bool isUtf8Locale();
+
+} }
+
+#endif // LIBCURSED__GUTS__CELL_HPP__
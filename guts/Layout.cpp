@@ -0,0 +1,205 @@
+// libcursed -- C++ classes for dealing with curses
+// Copyright (C) 2022 xaizek <xaizek@posteo.net>
+//
+// This file is part of libcursed.
+//
+// libcursed is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// libcursed is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with libcursed.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "Layout.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+#include "../Track.hpp"
+
+using namespace cursed;
+using namespace cursed::guts;
+namespace guts = cursed::guts;
+
+// Boundary to narrow range of values to avoid integer overflows.
+constexpr int Limit = 10000;
+
+void
+guts::doLayout(std::vector<int> &lengths, const std::vector<Flex> &flexes,
+               int max, std::vector<int> &layout)
+{
+    int nFlexible = 0;
+    int nWeighted = 0;
+    int totalWeight = 0;
+    int booked = 0;
+
+    layout.clear();
+    int lengthLeft = max;
+
+    auto getFlex = [&flexes, &lengths](unsigned int i) {
+        return (flexes[i].weight == 0 && lengths[i] <= -Limit)
+             ? Flex(1, 1)
+             : flexes[i];
+    };
+
+    for (unsigned int i = 0U; i < lengths.size(); ++i) {
+        int &length = lengths[i];
+        length = std::max(std::min(length, Limit), -Limit);
+
+        const Flex flex = getFlex(i);
+        if (flex.weight > 0) {
+            ++nWeighted;
+            totalWeight += flex.weight;
+            booked += flex.min;
+            layout.emplace_back();
+        } else if (length < 0) {
+            ++nFlexible;
+            booked += -length;
+            layout.emplace_back();
+        } else {
+            layout.emplace_back(length);
+            lengthLeft = std::max(0, lengthLeft - length);
+        }
+    }
+
+    // Not enough space, shrink items proportionally to their minimal lengths.
+    // Space lost to rounding goes to items that have room for it starting
+    // from the last one.
+    if (lengthLeft < booked) {
+        int have = lengthLeft;
+        for (unsigned int i = 0U; i < lengths.size(); ++i) {
+            const Flex flex = getFlex(i);
+            if (flex.weight > 0 || lengths[i] < 0) {
+                int length = (flex.weight > 0 ? flex.min : -lengths[i]);
+
+                layout[i] = lengthLeft*(float(length)/booked);
+                if (flex.weight > 0 && flex.max >= 0) {
+                    layout[i] = std::min(layout[i], flex.max);
+                }
+                have -= layout[i];
+            }
+        }
+
+        for (int i = lengths.size() - 1; i >= 0 && have > 0; --i) {
+            const Flex flex = getFlex(i);
+            if (flex.weight == 0 && lengths[i] >= 0) {
+                continue;
+            }
+
+            const int add = (flex.weight > 0 && flex.max >= 0)
+                          ? std::min(have, flex.max - layout[i])
+                          : have;
+            layout[i] += add;
+            have -= add;
+        }
+        return;
+    }
+
+    // Weighted items take extra space proportionally to their weights.  Items
+    // that would obviously exceed their upper bounds are limited first, then
+    // each of the rest gets its share of what's left after previous ones, so
+    // space not taken due to upper bounds goes to the following items.
+    // Limited items are recognized by having their maximum length assigned
+    // (other weighted items have zero at that point).
+    int extra = lengthLeft - booked;
+    if (nWeighted > 0) {
+        const int fullExtra = extra;
+        const int fullWeight = totalWeight;
+        for (unsigned int i = 0U; i < lengths.size(); ++i) {
+            const Flex flex = getFlex(i);
+            if (flex.weight == 0 || flex.max < 0) {
+                continue;
+            }
+
+            const long long share =
+                static_cast<long long>(fullExtra)*flex.weight/fullWeight;
+            if (flex.min + share >= flex.max) {
+                layout[i] = flex.max;
+                lengthLeft -= layout[i];
+                extra -= flex.max - flex.min;
+                totalWeight -= flex.weight;
+            }
+        }
+
+        for (unsigned int i = 0U; i < lengths.size(); ++i) {
+            const Flex flex = getFlex(i);
+            if (flex.weight == 0 || (flex.max >= 0 && layout[i] == flex.max)) {
+                continue;
+            }
+
+            int share = static_cast<long long>(extra)*flex.weight/totalWeight;
+            if (flex.max >= 0) {
+                share = std::min(share, flex.max - flex.min);
+            }
+            layout[i] = flex.min + share;
+            lengthLeft -= layout[i];
+            extra -= share;
+            totalWeight -= flex.weight;
+        }
+
+        // Leftover appears if items at the end reached their bounds.
+        for (unsigned int i = 0U; i < lengths.size() && extra > 0; ++i) {
+            const Flex flex = getFlex(i);
+            if (flex.weight == 0) {
+                continue;
+            }
+
+            if (flex.max < 0 || layout[i] < flex.max) {
+                const int add = (flex.max < 0)
+                              ? extra
+                              : std::min(extra, flex.max - layout[i]);
+                layout[i] += add;
+                lengthLeft -= add;
+                extra -= add;
+            }
+        }
+    }
+
+    // Place flexible items giving them share of extra space.
+    int extraFraction = (nFlexible != 0) ? extra/nFlexible : 0;
+    for (unsigned int i = 0U; i < lengths.size(); ++i) {
+        if (getFlex(i).weight == 0 && lengths[i] < 0) {
+            --nFlexible;
+            layout[i] = (nFlexible == 0)
+                      ? lengthLeft
+                      : std::min(lengthLeft, -lengths[i] + extraFraction);
+            lengthLeft -= layout[i];
+        }
+    }
+}
+
+bool
+guts::isFiller(int policy)
+{
+    return (policy <= -Limit);
+}
+
+int
+guts::getFlexPolicy(const Flex &flex)
+{
+    return (flex.min > 0 ? -flex.min : -Limit);
+}
+
+int
+guts::calculateDesired(const std::vector<int> &lengths)
+{
+    int minLength = 0;
+    int sign = 1;
+    for (int length : lengths) {
+        length = std::max(std::min(length, Limit), -Limit);
+        if (length != -Limit) {
+            minLength = std::max(minLength, std::abs(length));
+            if (length < 0) {
+                sign = -1;
+            }
+        }
+    }
+    return sign*minLength;
+}
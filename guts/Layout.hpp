@@ -0,0 +1,49 @@
+// libcursed -- C++ classes for dealing with curses
+// Copyright (C) 2022 xaizek <xaizek@posteo.net>
+//
+// This file is part of libcursed.
+//
+// libcursed is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// libcursed is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with libcursed.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef LIBCURSED__GUTS__LAYOUT_HPP__
+#define LIBCURSED__GUTS__LAYOUT_HPP__
+
+#include <vector>
+
+namespace cursed {
+
+struct Flex;
+
+namespace guts {
+
+// Performs distribution of `max` units among items that want specified
+// lengths (size policies) or have flex constraints (lengths of such items are
+// ignored).  Fillers are handled as items of weight 1 that need at least one
+// unit.  `lengths` is used as a scratch buffer, result is stored in `layout`.
+void doLayout(std::vector<int> &lengths, const std::vector<Flex> &flexes,
+              int max, std::vector<int> &layout);
+
+// Checks whether size policy asks for all free space.
+bool isFiller(int policy);
+
+// Converts flex constraints into size policy.
+int getFlexPolicy(const Flex &flex);
+
+// Calculates size policy of a container that stacks items in the other
+// direction based on their size policies.
+int calculateDesired(const std::vector<int> &lengths);
+
+} }
+
+#endif // LIBCURSED__GUTS__LAYOUT_HPP__
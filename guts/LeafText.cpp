@@ -0,0 +1,109 @@
+// libcursed -- C++ classes for dealing with curses
+// Copyright (C) 2022 xaizek <xaizek@posteo.net>
+//
+// This file is part of libcursed.
+//
+// libcursed is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// libcursed is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with libcursed.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "LeafText.hpp"
+
+#include <new>
+#include <string>
+#include <utility>
+
+#include "../utils.hpp"
+
+using namespace cursed::guts;
+
+LeafText::LeafText() : utf8Mode(false)
+{
+    new (&wide) std::wstring();
+}
+
+LeafText::LeafText(std::wstring text) : utf8Mode(false)
+{
+    new (&wide) std::wstring(std::move(text));
+}
+
+LeafText::LeafText(std::string text) : utf8Mode(true)
+{
+    new (&utf8) std::string(std::move(text));
+}
+
+LeafText::LeafText(const LeafText &rhs) : utf8Mode(rhs.utf8Mode)
+{
+    if (utf8Mode) {
+        new (&utf8) std::string(rhs.utf8);
+    } else {
+        new (&wide) std::wstring(rhs.wide);
+    }
+}
+
+LeafText::LeafText(LeafText &&rhs) noexcept
+{
+    construct(std::move(rhs));
+}
+
+LeafText &
+LeafText::operator=(LeafText rhs) noexcept
+{
+    destroy();
+    construct(std::move(rhs));
+    return *this;
+}
+
+LeafText::~LeafText()
+{
+    destroy();
+}
+
+int
+LeafText::length() const
+{
+    if (!utf8Mode) {
+        return wide.length();
+    }
+
+    return cursed::countUtf8Chars(utf8.data(), utf8.data() + utf8.size());
+}
+
+std::wstring
+LeafText::toWide() const
+{
+    return (utf8Mode ? cursed::fromUtf8(utf8) : wide);
+}
+
+void
+LeafText::construct(LeafText &&rhs)
+{
+    utf8Mode = rhs.utf8Mode;
+    if (utf8Mode) {
+        new (&utf8) std::string(std::move(rhs.utf8));
+    } else {
+        new (&wide) std::wstring(std::move(rhs.wide));
+    }
+}
+
+void
+LeafText::destroy()
+{
+    using std::string;
+    using std::wstring;
+
+    if (utf8Mode) {
+        utf8.~string();
+    } else {
+        wide.~wstring();
+    }
+}
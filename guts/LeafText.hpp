@@ -0,0 +1,84 @@
+// libcursed -- C++ classes for dealing with curses
+// Copyright (C) 2022 xaizek <xaizek@posteo.net>
+//
+// This file is part of libcursed.
+//
+// libcursed is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// libcursed is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with libcursed.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef LIBCURSED__GUTS__LEAFTEXT_HPP__
+#define LIBCURSED__GUTS__LEAFTEXT_HPP__
+
+#include <string>
+
+namespace cursed { namespace guts {
+
+// Text of a leaf of a tree, which is stored either as a wide string or as
+// UTF-8.  Takes up a single string and a tag instead of a pair of strings.
+class LeafText
+{
+public:
+    // Constructs empty wide text.
+    LeafText();
+    // Constructs wide text.
+    LeafText(std::wstring text);
+    // Constructs UTF-8 text.
+    LeafText(std::string text);
+
+    // Copies text.
+    LeafText(const LeafText &rhs);
+    // Moves text.
+    LeafText(LeafText &&rhs) noexcept;
+    // Replaces text.
+    LeafText & operator=(LeafText rhs) noexcept;
+
+    // Frees resources.
+    ~LeafText();
+
+public:
+    // Checks whether text is stored as UTF-8.
+    bool isUtf8() const
+    { return utf8Mode; }
+    // Retrieves wide text.  Should be called only for wide text.
+    const std::wstring & getWide() const
+    { return wide; }
+    // Retrieves UTF-8 text.  Should be called only for UTF-8 text.
+    const std::string & getUtf8() const
+    { return utf8; }
+
+    // Checks whether text is empty.
+    bool empty() const
+    { return (utf8Mode ? utf8.empty() : wide.empty()); }
+    // Retrieves number of characters.
+    int length() const;
+    // Retrieves text as a wide string.
+    std::wstring toWide() const;
+
+private:
+    // Initializes storage by moving from another object.
+    void construct(LeafText &&rhs);
+    // Destroys active member of the union.
+    void destroy();
+
+private:
+    union
+    {
+        std::wstring wide; // Wide text.
+        std::string utf8;  // UTF-8 text.
+    };
+    bool utf8Mode; // Whether `utf8` is the active member.
+};
+
+} }
+
+#endif // LIBCURSED__GUTS__LEAFTEXT_HPP__
@@ -0,0 +1,310 @@
+// libcursed -- C++ classes for dealing with curses
+// Copyright (C) 2022 xaizek <xaizek@posteo.net>
+//
+// This file is part of libcursed.
+//
+// libcursed is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// libcursed is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with libcursed.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "LineRope.hpp"
+
+#include <cstddef>
+
+#include <algorithm>
+#include <iterator>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "Cell.hpp"
+
+using namespace cursed::guts;
+
+// Number of lines in newly built chunks.  Leaves some space for insertions.
+static const int ChunkSize = 256;
+// Maximum number of lines in a chunk.
+static const int MaxChunkSize = 2*ChunkSize;
+// Chunks smaller than this are combined with their neighbours when possible.
+static const int MinChunkSize = ChunkSize/4;
+
+// Chunk of lines and root of a subtree.  The tree is a treap with implicit
+// keys: lines of left subtree precede lines of the chunk, which precede lines
+// of the right subtree.
+struct LineRope::Node
+{
+    std::vector<TextLine> lines; // Lines of this chunk.
+    NodePtr left;                // Preceding chunks.
+    NodePtr right;               // Following chunks.
+    unsigned int priority;       // Random priority of a heap.
+    int count;                   // Number of lines in the subtree.
+};
+
+LineRope::LineRope() : skipped(0)
+{ }
+
+LineRope::~LineRope() = default;
+
+int
+LineRope::size() const
+{
+    return count(root) - skipped;
+}
+
+TextLine &
+LineRope::operator[](int i)
+{
+    i += skipped;
+    Node *node = find(root.get(), i);
+    return node->lines[i];
+}
+
+const TextLine &
+LineRope::operator[](int i) const
+{
+    i += skipped;
+    Node *node = find(root.get(), i);
+    return node->lines[i];
+}
+
+void
+LineRope::clear()
+{
+    root.reset();
+    skipped = 0;
+}
+
+void
+LineRope::insert(int at, std::vector<Cell> lines)
+{
+    if (!insertIntoChunk(root.get(), skipped + at, lines)) {
+        insertChunks(skipped + at, lines);
+    }
+}
+
+void
+LineRope::erase(int from, int count)
+{
+    if (count <= 0) {
+        return;
+    }
+
+    std::pair<NodePtr, NodePtr> head = split(std::move(root), skipped + from);
+    std::pair<NodePtr, NodePtr> tail = split(std::move(head.second), count);
+    root = concat(std::move(head.first), std::move(tail.second));
+}
+
+void
+LineRope::eraseFront(int count)
+{
+    // Lines are only marked as erased until the whole first chunk can be
+    // dropped, which doesn't require moving lines around.
+    skipped += count;
+    while (root != nullptr) {
+        const int firstCount = edge(root.get(), false)->lines.size();
+        if (skipped < firstCount) {
+            break;
+        }
+
+        root = split(std::move(root), firstCount).second;
+        skipped -= firstCount;
+    }
+}
+
+bool
+LineRope::insertIntoChunk(Node *node, int at, std::vector<Cell> &lines)
+{
+    if (node == nullptr) {
+        return false;
+    }
+
+    const int leftCount = count(node->left);
+    const int ownCount = node->lines.size();
+
+    bool inserted;
+    if (at < leftCount) {
+        inserted = insertIntoChunk(node->left.get(), at, lines);
+    } else if (at > leftCount + ownCount) {
+        inserted = insertIntoChunk(node->right.get(),
+                                   at - leftCount - ownCount, lines);
+    } else if (ownCount + lines.size() <= MaxChunkSize) {
+        node->lines.insert(node->lines.begin() + (at - leftCount),
+                           std::make_move_iterator(lines.begin()),
+                           std::make_move_iterator(lines.end()));
+        inserted = true;
+    } else {
+        inserted = false;
+    }
+
+    if (inserted) {
+        node->count += lines.size();
+    }
+    return inserted;
+}
+
+void
+LineRope::insertChunks(int at, std::vector<Cell> &lines)
+{
+    NodePtr middle;
+    for (std::size_t i = 0U; i < lines.size(); i += ChunkSize) {
+        const std::size_t end = std::min(lines.size(), i + ChunkSize);
+
+        NodePtr chunk(new Node());
+        chunk->priority = rng();
+        chunk->lines.reserve(end - i);
+        for (std::size_t j = i; j < end; ++j) {
+            chunk->lines.emplace_back(std::move(lines[j]));
+        }
+        update(*chunk);
+
+        middle = merge(std::move(middle), std::move(chunk));
+    }
+
+    std::pair<NodePtr, NodePtr> parts = split(std::move(root), at);
+    root = concat(concat(std::move(parts.first), std::move(middle)),
+                  std::move(parts.second));
+}
+
+int
+LineRope::count(const NodePtr &node)
+{
+    return (node == nullptr ? 0 : node->count);
+}
+
+void
+LineRope::update(Node &node)
+{
+    node.count = count(node.left) + node.lines.size() + count(node.right);
+}
+
+LineRope::NodePtr
+LineRope::merge(NodePtr lhs, NodePtr rhs)
+{
+    if (lhs == nullptr) {
+        return rhs;
+    }
+    if (rhs == nullptr) {
+        return lhs;
+    }
+
+    if (lhs->priority > rhs->priority) {
+        lhs->right = merge(std::move(lhs->right), std::move(rhs));
+        update(*lhs);
+        return lhs;
+    }
+
+    rhs->left = merge(std::move(lhs), std::move(rhs->left));
+    update(*rhs);
+    return rhs;
+}
+
+LineRope::NodePtr
+LineRope::concat(NodePtr lhs, NodePtr rhs)
+{
+    if (lhs == nullptr || rhs == nullptr) {
+        return merge(std::move(lhs), std::move(rhs));
+    }
+
+    const int lhsCount = count(lhs);
+    const int lastCount = edge(lhs.get(), true)->lines.size();
+    const int firstCount = edge(rhs.get(), false)->lines.size();
+    if (std::min(lastCount, firstCount) >= MinChunkSize ||
+        lastCount + firstCount > MaxChunkSize) {
+        return merge(std::move(lhs), std::move(rhs));
+    }
+
+    // Splitting at chunk boundaries detaches the chunks as single nodes.
+    std::pair<NodePtr, NodePtr> left = split(std::move(lhs),
+                                             lhsCount - lastCount);
+    std::pair<NodePtr, NodePtr> right = split(std::move(rhs), firstCount);
+
+    std::vector<TextLine> &lines = left.second->lines;
+    std::vector<TextLine> &tail = right.first->lines;
+    lines.insert(lines.end(), std::make_move_iterator(tail.begin()),
+                 std::make_move_iterator(tail.end()));
+    update(*left.second);
+
+    return merge(merge(std::move(left.first), std::move(left.second)),
+                 std::move(right.second));
+}
+
+std::pair<LineRope::NodePtr, LineRope::NodePtr>
+LineRope::split(NodePtr node, int at)
+{
+    if (node == nullptr) {
+        return {};
+    }
+
+    const int leftCount = count(node->left);
+    const int ownCount = node->lines.size();
+
+    if (at <= leftCount) {
+        std::pair<NodePtr, NodePtr> parts = split(std::move(node->left), at);
+        node->left = std::move(parts.second);
+        update(*node);
+        return { std::move(parts.first), std::move(node) };
+    }
+
+    if (at >= leftCount + ownCount) {
+        std::pair<NodePtr, NodePtr> parts = split(std::move(node->right),
+                                                  at - leftCount - ownCount);
+        node->right = std::move(parts.first);
+        update(*node);
+        return { std::move(node), std::move(parts.second) };
+    }
+
+    // The chunk itself needs to be split.  The tail inherits priority of the
+    // node, which keeps the heap property of the right subtree.
+    const auto mid = node->lines.begin() + (at - leftCount);
+    NodePtr tail(new Node());
+    tail->priority = node->priority;
+    tail->lines.assign(std::make_move_iterator(mid),
+                       std::make_move_iterator(node->lines.end()));
+    tail->right = std::move(node->right);
+    node->lines.erase(mid, node->lines.end());
+    update(*tail);
+    update(*node);
+    return { std::move(node), std::move(tail) };
+}
+
+LineRope::Node *
+LineRope::find(Node *node, int &i)
+{
+    while (true) {
+        const int leftCount = count(node->left);
+        if (i < leftCount) {
+            node = node->left.get();
+            continue;
+        }
+
+        i -= leftCount;
+        const int ownCount = node->lines.size();
+        if (i < ownCount) {
+            return node;
+        }
+
+        i -= ownCount;
+        node = node->right.get();
+    }
+}
+
+LineRope::Node *
+LineRope::edge(Node *node, bool last)
+{
+    while (true) {
+        Node *next = (last ? node->right.get() : node->left.get());
+        if (next == nullptr) {
+            return node;
+        }
+        node = next;
+    }
+}
@@ -0,0 +1,118 @@
+// libcursed -- C++ classes for dealing with curses
+// Copyright (C) 2022 xaizek <xaizek@posteo.net>
+//
+// This file is part of libcursed.
+//
+// libcursed is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// libcursed is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with libcursed.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef LIBCURSED__GUTS__LINEROPE_HPP__
+#define LIBCURSED__GUTS__LINEROPE_HPP__
+
+#include <memory>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Cell.hpp"
+
+namespace cursed { namespace guts {
+
+// Line of text along with data derived from it.
+struct TextLine
+{
+    // Constructs a line out of its contents.
+    TextLine(Cell cell) : cell(std::move(cell)), state(0)
+    { }
+
+    Cell cell;                           // Contents of the line.
+    std::unique_ptr<std::string> shadow; // Plain text in UTF-8 or `nullptr`.
+    int state;                           // Highlighter state at line start.
+};
+
+// Sequence of lines stored in chunks, which are organized into a balanced
+// tree.  Accessing a line and inserting or erasing a range of lines take
+// logarithmic time in the number of chunks (plus size of the range).
+// Erasing leading lines takes amortized constant time per line.
+class LineRope
+{
+    struct Node;
+    using NodePtr = std::unique_ptr<Node>;
+
+public:
+    // Constructs an empty sequence.
+    LineRope();
+    // Emit destructing code in corresponding source file.
+    ~LineRope();
+
+    LineRope(const LineRope &rhs) = delete;
+    LineRope(LineRope &&rhs) = delete;
+    LineRope & operator=(const LineRope &rhs) = delete;
+    LineRope & operator=(LineRope &&rhs) = delete;
+
+public:
+    // Retrieves number of lines.
+    int size() const;
+    // Checks whether there are no lines.
+    bool empty() const
+    { return size() == 0; }
+
+    // Retrieves line by its index (should be a valid one).  Different lines
+    // can be accessed from multiple threads simultaneously.
+    TextLine & operator[](int i);
+    // Retrieves line by its index (should be a valid one).
+    const TextLine & operator[](int i) const;
+
+    // Removes all lines.
+    void clear();
+    // Inserts lines before the one at `at` (which can be equal to `size()`).
+    void insert(int at, std::vector<Cell> lines);
+    // Removes `count` lines starting at `from`.
+    void erase(int from, int count);
+    // Removes `count` first lines.
+    void eraseFront(int count);
+
+private:
+    // Tries to insert lines into an existing chunk.  Returns `false` if there
+    // is no suitable chunk.
+    static bool insertIntoChunk(Node *node, int at, std::vector<Cell> &lines);
+    // Builds a tree out of lines and inserts it at `at`.
+    void insertChunks(int at, std::vector<Cell> &lines);
+
+    // Retrieves number of lines in a subtree.
+    static int count(const NodePtr &node);
+    // Recomputes number of lines in a subtree after its children have changed.
+    static void update(Node &node);
+    // Joins two trees with all lines of the first one preceding lines of the
+    // second one.
+    static NodePtr merge(NodePtr lhs, NodePtr rhs);
+    // Same as `merge()`, but also combines chunks at the junction if one of
+    // them is undersized.
+    static NodePtr concat(NodePtr lhs, NodePtr rhs);
+    // Splits a tree into first `at` lines and the rest.
+    static std::pair<NodePtr, NodePtr> split(NodePtr node, int at);
+    // Finds chunk that contains i-th line and makes `i` relative to the chunk.
+    static Node * find(Node *node, int &i);
+    // Finds the first (`last` is `false`) or the last chunk of a tree.
+    static Node * edge(Node *node, bool last);
+
+private:
+    NodePtr root;         // Root of the tree or `nullptr`.
+    int skipped;          // Number of erased lines at the start of the tree.
+    std::minstd_rand rng; // Source of priorities for balancing the tree.
+};
+
+} }
+
+#endif // LIBCURSED__GUTS__LINEROPE_HPP__
@@ -0,0 +1,82 @@
+// libcursed -- C++ classes for dealing with curses
+// Copyright (C) 2022 xaizek <xaizek@posteo.net>
+//
+// This file is part of libcursed.
+//
+// libcursed is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// libcursed is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with libcursed.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "Matcher.hpp"
+
+#include <cstddef>
+#include <cstring>
+
+#include <regex>
+#include <string>
+#include <vector>
+
+#include "../utils.hpp"
+
+using namespace cursed::guts;
+
+Matcher::Matcher(const std::wstring &pattern, bool regex)
+    : needle(cursed::toUtf8(pattern))
+{
+    if (regex) {
+        this->regex.reset(new std::wregex(pattern));
+    }
+}
+
+void
+Matcher::findAll(const std::string &utf8, std::vector<MatchPos> &matches) const
+{
+    const char *const begin = utf8.data();
+    const char *const end = begin + utf8.size();
+
+    // Character offset is computed incrementally to avoid rescanning prefix of
+    // the string for every match.
+    const char *counted = begin;
+    int col = 0;
+    auto add = [&](const char *from, const char *to) {
+        col += cursed::countUtf8Chars(counted, from);
+        counted = from;
+        matches.push_back({ col, cursed::countUtf8Chars(from, to) });
+    };
+
+    if (regex != nullptr) {
+        // Matching is done on wide string for `.` and character classes to
+        // match whole characters rather than bytes.
+        const std::wstring wide = cursed::fromUtf8(utf8);
+        std::wsregex_iterator it(wide.cbegin(), wide.cend(), *regex), itEnd;
+        for (; it != itEnd; ++it) {
+            if (it->length() != 0) {
+                matches.push_back({ static_cast<int>(it->position()),
+                                    static_cast<int>(it->length()) });
+            }
+        }
+        return;
+    }
+
+    if (needle.empty()) {
+        return;
+    }
+
+    // memmem() is well optimized and doesn't need preprocessing of the needle.
+    const char *p = begin;
+    while (const void *found = memmem(p, end - p,
+                                      needle.data(), needle.size())) {
+        const char *from = static_cast<const char *>(found);
+        add(from, from + needle.size());
+        p = from + needle.size();
+    }
+}
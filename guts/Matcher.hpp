@@ -0,0 +1,57 @@
+// libcursed -- C++ classes for dealing with curses
+// Copyright (C) 2022 xaizek <xaizek@posteo.net>
+//
+// This file is part of libcursed.
+//
+// libcursed is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// libcursed is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with libcursed.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef LIBCURSED__GUTS__MATCHER_HPP__
+#define LIBCURSED__GUTS__MATCHER_HPP__
+
+#include <memory>
+#include <regex>
+#include <string>
+#include <vector>
+
+namespace cursed { namespace guts {
+
+// Position of a match within a string in characters.
+struct MatchPos
+{
+    int col; // Offset of the match.
+    int len; // Length of the match.
+};
+
+// Finds occurrences of a pattern in UTF-8 strings.  Pattern is either a plain
+// substring or an ECMAScript regular expression.  Can be used from multiple
+// threads simultaneously.
+class Matcher
+{
+public:
+    // Prepares pattern for matching.  Throws `std::regex_error` on invalid
+    // regular expression.
+    Matcher(const std::wstring &pattern, bool regex);
+
+public:
+    // Appends all non-overlapping matches in the string to the list.
+    void findAll(const std::string &utf8, std::vector<MatchPos> &matches) const;
+
+private:
+    std::string needle;                 // Substring to look for.
+    std::unique_ptr<std::wregex> regex; // Regular expression or `nullptr`.
+};
+
+} }
+
+#endif // LIBCURSED__GUTS__MATCHER_HPP__
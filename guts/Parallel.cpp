@@ -0,0 +1,96 @@
+// libcursed -- C++ classes for dealing with curses
+// Copyright (C) 2022 xaizek <xaizek@posteo.net>
+//
+// This file is part of libcursed.
+//
+// libcursed is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// libcursed is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with libcursed.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "Parallel.hpp"
+
+#include <cstddef>
+
+#include <algorithm>
+#include <exception>
+#include <thread>
+#include <vector>
+
+using namespace cursed::guts;
+namespace guts = cursed::guts;
+
+// Minimal number of elements per chunk, smaller chunks aren't worth starting a
+// thread.
+constexpr std::size_t MinChunkSize = 16*1024;
+
+int
+guts::countChunks(std::size_t count, int workers)
+{
+    if (workers <= 0) {
+        workers = std::thread::hardware_concurrency();
+    }
+
+    std::size_t maxChunks = count/MinChunkSize;
+    return std::max<std::size_t>(1U, std::min<std::size_t>(workers, maxChunks));
+}
+
+void
+guts::parallelFor(std::size_t count, int nChunks, const chunkFunc &func)
+{
+    if (nChunks <= 1) {
+        func(0, 0U, count);
+        return;
+    }
+
+    const std::size_t chunkSize = count/nChunks;
+    const std::size_t extra = count%nChunks;
+    auto getStart = [&](int chunk) {
+        return chunk*chunkSize + std::min<std::size_t>(chunk, extra);
+    };
+
+    // Exceptions can't leave threads, so they are passed to the caller.
+    std::vector<std::exception_ptr> errors(nChunks);
+    auto run = [&](int chunk) {
+        try {
+            func(chunk, getStart(chunk), getStart(chunk + 1));
+        } catch (...) {
+            errors[chunk] = std::current_exception();
+        }
+    };
+
+    std::vector<std::thread> threads;
+    int started = 1;
+    try {
+        threads.reserve(nChunks - 1);
+        for (; started < nChunks; ++started) {
+            threads.emplace_back(run, started);
+        }
+    } catch (...) {
+        // Chunks that didn't get a thread are processed by the calling one.
+    }
+
+    // The calling thread is one of the workers.
+    run(0);
+    for (int i = started; i < nChunks; ++i) {
+        run(i);
+    }
+
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+
+    for (const std::exception_ptr &error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+}
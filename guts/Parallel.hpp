@@ -0,0 +1,46 @@
+// libcursed -- C++ classes for dealing with curses
+// Copyright (C) 2022 xaizek <xaizek@posteo.net>
+//
+// This file is part of libcursed.
+//
+// libcursed is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// libcursed is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with libcursed.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef LIBCURSED__GUTS__PARALLEL_HPP__
+#define LIBCURSED__GUTS__PARALLEL_HPP__
+
+#include <cstddef>
+
+#include <functional>
+
+namespace cursed { namespace guts {
+
+// Type of function that processes elements in [from, to) range as a chunk
+// number `chunk`.
+using chunkFunc = std::function<void(int chunk, std::size_t from,
+                                     std::size_t to)>;
+
+// Computes number of chunks to split `count` elements into given maximum
+// number of workers (zero means number of hardware threads).  Small inputs
+// aren't split.  Always returns at least one.
+int countChunks(std::size_t count, int workers);
+
+// Splits [0, count) into `nChunks` contiguous chunks of nearly equal size in
+// order and processes them in parallel.  Returns after all chunks are done.
+// If processing of chunks throws, the first exception (in order of chunks) is
+// rethrown.
+void parallelFor(std::size_t count, int nChunks, const chunkFunc &func);
+
+} }
+
+#endif // LIBCURSED__GUTS__PARALLEL_HPP__
@@ -0,0 +1,161 @@
+// libcursed -- C++ classes for dealing with curses
+// Copyright (C) 2022 xaizek <xaizek@posteo.net>
+//
+// This file is part of libcursed.
+//
+// libcursed is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// libcursed is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with libcursed.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "RangeSet.hpp"
+
+#include <algorithm>
+#include <vector>
+
+using namespace cursed;
+using namespace cursed::guts;
+
+// Appends a range to sorted list of ranges merging it with the last one if
+// they touch.
+static void append(std::vector<Range> &ranges, int from, int to);
+
+void
+RangeSet::add(int from, int to)
+{
+    if (from >= to) {
+        return;
+    }
+
+    // Ranges that overlap or touch the new one get absorbed by it.
+    auto first = std::lower_bound(ranges.begin(), ranges.end(), from,
+                                  [](const Range &r, int i) {
+                                      return r.to < i;
+                                  });
+    auto last = std::upper_bound(first, ranges.end(), to,
+                                 [](int i, const Range &r) {
+                                     return i < r.from;
+                                 });
+
+    for (auto it = first; it != last; ++it) {
+        total -= it->to - it->from;
+        from = std::min(from, it->from);
+        to = std::max(to, it->to);
+    }
+    total += to - from;
+
+    auto it = ranges.erase(first, last);
+    ranges.insert(it, Range { from, to });
+}
+
+void
+RangeSet::remove(int from, int to)
+{
+    if (from >= to) {
+        return;
+    }
+
+    auto first = std::upper_bound(ranges.begin(), ranges.end(), from,
+                                  [](int i, const Range &r) {
+                                      return i < r.to;
+                                  });
+    auto last = std::lower_bound(first, ranges.end(), to,
+                                 [](const Range &r, int i) {
+                                     return r.from < i;
+                                 });
+    if (first == last) {
+        return;
+    }
+
+    // Parts of the outermost ranges that stick out survive.
+    std::vector<Range> rest;
+    if (first->from < from) {
+        rest.push_back({ first->from, from });
+    }
+    if ((last - 1)->to > to) {
+        rest.push_back({ to, (last - 1)->to });
+    }
+
+    for (auto it = first; it != last; ++it) {
+        total -= it->to - it->from;
+    }
+    for (const Range &r : rest) {
+        total += r.to - r.from;
+    }
+
+    auto it = ranges.erase(first, last);
+    ranges.insert(it, rest.cbegin(), rest.cend());
+}
+
+void
+RangeSet::invert(int from, int to)
+{
+    if (from >= to) {
+        return;
+    }
+
+    std::vector<Range> result;
+    result.reserve(ranges.size() + 1U);
+
+    int gap = from; // Start of a part of [from, to) not covered by ranges.
+    for (const Range &r : ranges) {
+        if (r.to <= from) {
+            append(result, r.from, r.to);
+        } else if (r.from >= to) {
+            append(result, gap, to);
+            gap = to;
+            append(result, r.from, r.to);
+        } else {
+            append(result, r.from, from);
+            append(result, gap, r.from);
+            gap = std::max(gap, std::min(r.to, to));
+            append(result, to, r.to);
+        }
+    }
+    append(result, gap, to);
+
+    ranges = std::move(result);
+    total = 0;
+    for (const Range &r : ranges) {
+        total += r.to - r.from;
+    }
+}
+
+void
+RangeSet::clear()
+{
+    ranges.clear();
+    total = 0;
+}
+
+bool
+RangeSet::contains(int i) const
+{
+    auto it = std::upper_bound(ranges.cbegin(), ranges.cend(), i,
+                               [](int n, const Range &r) {
+                                   return n < r.to;
+                               });
+    return (it != ranges.cend() && it->from <= i);
+}
+
+static void
+append(std::vector<Range> &ranges, int from, int to)
+{
+    if (from >= to) {
+        return;
+    }
+
+    if (!ranges.empty() && ranges.back().to >= from) {
+        ranges.back().to = std::max(ranges.back().to, to);
+    } else {
+        ranges.push_back({ from, to });
+    }
+}
@@ -0,0 +1,67 @@
+// libcursed -- C++ classes for dealing with curses
+// Copyright (C) 2022 xaizek <xaizek@posteo.net>
+//
+// This file is part of libcursed.
+//
+// libcursed is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// libcursed is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with libcursed.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef LIBCURSED__GUTS__RANGESET_HPP__
+#define LIBCURSED__GUTS__RANGESET_HPP__
+
+#include <vector>
+
+namespace cursed { namespace guts {
+
+// Half-open range of integers.
+struct Range
+{
+    int from; // First element.
+    int to;   // Element past the last one.
+};
+
+// Set of integers stored as sorted list of disjoint ranges.  Cost of
+// operations depends on number of ranges rather than on number of elements, so
+// sets like "all of a million elements" are cheap.
+class RangeSet
+{
+public:
+    // Adds elements in [from, to).
+    void add(int from, int to);
+    // Removes elements in [from, to).
+    void remove(int from, int to);
+    // Adds missing and removes present elements in [from, to).
+    void invert(int from, int to);
+    // Removes all elements.
+    void clear();
+
+    // Checks whether an element is in the set.
+    bool contains(int i) const;
+    // Retrieves number of elements in the set.
+    int count() const
+    { return total; }
+    // Checks whether the set has no elements.
+    bool empty() const
+    { return ranges.empty(); }
+    // Retrieves sorted list of ranges.  Ranges don't overlap or touch.
+    const std::vector<Range> & getRanges() const
+    { return ranges; }
+
+private:
+    std::vector<Range> ranges; // Sorted disjoint ranges.
+    int total = 0;             // Number of elements.
+};
+
+} }
+
+#endif // LIBCURSED__GUTS__RANGESET_HPP__
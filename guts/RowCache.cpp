@@ -0,0 +1,188 @@
+// libcursed -- C++ classes for dealing with curses
+// Copyright (C) 2022 xaizek <xaizek@posteo.net>
+//
+// This file is part of libcursed.
+//
+// libcursed is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// libcursed is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with libcursed.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "RowCache.hpp"
+
+#include <cassert>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "Cell.hpp"
+
+using namespace cursed;
+using namespace cursed::guts;
+
+void
+guts::appendRuns(std::vector<Run> &runs, const ColorTree &tree,
+                 const Format &base)
+{
+    tree.visit([&runs](const std::wstring &text, const Format &format) {
+        if (!text.empty()) {
+            runs.emplace_back(text, format);
+        }
+    }, base);
+}
+
+void
+guts::appendRuns(std::vector<Run> &runs, const Cell &cell, const Format &base)
+{
+    cell.visit([&runs](const std::wstring &text, const Format &format) {
+        if (!text.empty()) {
+            runs.emplace_back(text, format);
+        }
+    }, base);
+}
+
+void
+guts::highlightRuns(std::vector<Run> &runs, int from, int len,
+                    const Format &hi)
+{
+    std::vector<Run> result;
+    result.reserve(runs.size() + 2U);
+
+    int offset = 0;
+    for (Run &run : runs) {
+        const int runLen = run.text.length();
+        const int a = std::max(0, std::min(from - offset, runLen));
+        const int b = std::max(0, std::min(from + len - offset, runLen));
+        offset += runLen;
+
+        if (a >= b) {
+            result.push_back(std::move(run));
+            continue;
+        }
+
+        Format format = run.format;
+        format += hi;
+
+        if (a > 0) {
+            result.emplace_back(run.text.substr(0, a), run.format);
+        }
+        result.emplace_back(run.text.substr(a, b - a), format);
+        if (b < runLen) {
+            result.emplace_back(run.text.substr(b), run.format);
+        }
+    }
+
+    runs.swap(result);
+}
+
+std::vector<Run>
+guts::sliceRuns(const std::vector<Run> &runs, int from, int len)
+{
+    std::vector<Run> slice;
+
+    int offset = 0;
+    for (const Run &run : runs) {
+        const int runLen = run.text.length();
+        const int a = std::max(0, std::min(from - offset, runLen));
+        const int b = std::max(0, std::min(from + len - offset, runLen));
+        offset += runLen;
+
+        if (a < b) {
+            slice.emplace_back(run.text.substr(a, b - a), run.format);
+        }
+        if (offset >= from + len) {
+            break;
+        }
+    }
+
+    return slice;
+}
+
+void
+RowCache::clear()
+{
+    for (Entry &entry : entries) {
+        entry.row = -1;
+        entry.runs.clear();
+    }
+}
+
+void
+RowCache::invalidate(int row)
+{
+    if (Entry *entry = getEntry(row)) {
+        entry->row = -1;
+        entry->runs.clear();
+    }
+}
+
+void
+RowCache::shift(int from, int count, int n)
+{
+    // Entries are indexed by row, so moved ones need to be placed anew.
+    std::vector<Entry> old(entries.size());
+    old.swap(entries);
+    for (Entry &entry : old) {
+        if (entry.row < 0 || (entry.row >= from && entry.row < from + count)) {
+            continue;
+        }
+
+        if (entry.row >= from + count) {
+            entry.row += n - count;
+        }
+        entries[entry.row%entries.size()] = std::move(entry);
+    }
+}
+
+void
+RowCache::resize(int size)
+{
+    entries.clear();
+    entries.resize(size < 0 ? 0 : size);
+}
+
+const std::vector<Run> *
+RowCache::find(int row, int state) const
+{
+    if (entries.empty()) {
+        return nullptr;
+    }
+
+    const Entry &entry = entries[row%entries.size()];
+    if (entry.row != row || entry.state != state) {
+        return nullptr;
+    }
+    return &entry.runs;
+}
+
+std::vector<Run> &
+RowCache::store(int row, int state)
+{
+    assert(!entries.empty() && "Can't store rows in an empty cache.");
+
+    Entry &entry = entries[row%entries.size()];
+    entry.row = row;
+    entry.state = state;
+    entry.runs.clear();
+    return entry.runs;
+}
+
+RowCache::Entry *
+RowCache::getEntry(int row)
+{
+    if (entries.empty()) {
+        return nullptr;
+    }
+
+    Entry &entry = entries[row%entries.size()];
+    return (entry.row == row ? &entry : nullptr);
+}
@@ -0,0 +1,96 @@
+// libcursed -- C++ classes for dealing with curses
+// Copyright (C) 2022 xaizek <xaizek@posteo.net>
+//
+// This file is part of libcursed.
+//
+// libcursed is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// libcursed is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with libcursed.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef LIBCURSED__GUTS__ROWCACHE_HPP__
+#define LIBCURSED__GUTS__ROWCACHE_HPP__
+
+#include <string>
+#include <vector>
+
+#include "../ColorTree.hpp"
+
+namespace cursed { namespace guts {
+
+// Piece of text with its final format (all formats are already merged).
+struct Run
+{
+    Run(std::wstring text, Format format)
+        : text(std::move(text)), format(std::move(format))
+    { }
+
+    std::wstring text; // Text of the run.
+    Format format;     // Format of the text.
+};
+
+class Cell;
+
+// Appends leafs of the tree to the list of runs applying `base` format.
+void appendRuns(std::vector<Run> &runs, const ColorTree &tree,
+                const Format &base = {});
+// Appends contents of a cell to the list of runs applying `base` format.
+void appendRuns(std::vector<Run> &runs, const Cell &cell,
+                const Format &base = {});
+// Merges `hi` format into `len` characters of runs starting at `from` by
+// splitting runs where necessary.
+void highlightRuns(std::vector<Run> &runs, int from, int len,
+                   const Format &hi);
+// Retrieves `len` characters of runs starting at `from`.
+std::vector<Run> sliceRuns(const std::vector<Run> &runs, int from, int len);
+
+// Caches rendered rows of a list-like widget.  Only as many rows as fit on the
+// screen are kept, which is enough to redraw unchanged page without rendering
+// rows anew.
+class RowCache
+{
+public:
+    // Drops all cached rows.
+    void clear();
+    // Drops cached version of a single row.
+    void invalidate(int row);
+    // Updates indexes of rows after `count` rows starting at `from` were
+    // replaced with `n` rows dropping the replaced ones.
+    void shift(int from, int count, int n);
+    // Sets how many rows can be cached at once (dropping all of them).
+    void resize(int size);
+
+    // Retrieves cached runs of a row rendered in specified highlight state or
+    // `nullptr` if there are none.
+    const std::vector<Run> * find(int row, int state) const;
+    // Makes an empty entry for a row in specified highlight state.  Returns
+    // list of runs to be filled in by the caller.
+    std::vector<Run> & store(int row, int state);
+
+private:
+    // Single cached row.
+    struct Entry
+    {
+        int row = -1;          // Index of the row or -1 for unused entry.
+        int state = 0;         // Highlight state the row was rendered in.
+        std::vector<Run> runs; // Rendered row.
+    };
+
+    // Retrieves entry corresponding to the row or `nullptr`.
+    Entry * getEntry(int row);
+
+private:
+    std::vector<Entry> entries; // Cache entries indexed by row modulo size.
+};
+
+} }
+
+#endif // LIBCURSED__GUTS__ROWCACHE_HPP__
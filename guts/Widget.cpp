@@ -18,12 +18,11 @@
 
 #include "Widget.hpp"
 
-#include "Pos.hpp"
-#include "Size.hpp"
-
 using cursed::guts::Widget;
 
-Widget::Widget() : hasFixedSize(false)
+Widget::Widget()
+    : hasFixedSize(false), parent(nullptr), heightCached(false),
+      widthCached(false), placeValid(false), hidden(false)
 { }
 
 void
@@ -32,20 +31,80 @@ Widget::setFixedSize(int colsNum, int linesNum)
     hasFixedSize = true;
     cols = colsNum;
     lines = linesNum;
+    invalidateSize();
+}
+
+void
+Widget::setParent(Widget *newParent)
+{
+    parent = newParent;
 }
 
 int
 Widget::getDesiredHeight()
-{ return (hasFixedSize ? lines : desiredHeight()); }
+{
+    if (hasFixedSize) {
+        return lines;
+    }
+    if (!heightCached) {
+        cachedHeight = desiredHeight();
+        heightCached = true;
+    }
+    return cachedHeight;
+}
 
 int
 Widget::getDesiredWidth()
-{ return (hasFixedSize ? cols : desiredWidth()); }
+{
+    if (hasFixedSize) {
+        return cols;
+    }
+    if (!widthCached) {
+        cachedWidth = desiredWidth();
+        widthCached = true;
+    }
+    return cachedWidth;
+}
+
+void
+Widget::invalidateSize()
+{
+    heightCached = false;
+    widthCached = false;
+    placeValid = false;
+
+    Widget *child = this;
+    for (Widget *w = parent; w != nullptr; child = w, w = w->parent) {
+        w->childResized(child);
+        if (!w->heightCached && !w->widthCached && !w->placeValid) {
+            break;
+        }
+        w->heightCached = false;
+        w->widthCached = false;
+        w->placeValid = false;
+    }
+}
 
 void
 Widget::place(Pos newPos, Size newSize)
-{ placed(newPos, newSize); }
+{
+    if (placeValid && newPos.x == lastPos.x && newPos.y == lastPos.y &&
+        newSize.lines == lastSize.lines && newSize.cols == lastSize.cols) {
+        return;
+    }
+
+    placed(newPos, newSize);
+
+    hidden = (newSize.lines == 0 || newSize.cols == 0);
+    lastPos = newPos;
+    lastSize = newSize;
+    placeValid = true;
+}
 
 void
 Widget::placed(Pos /*newPos*/, Size /*newSize*/)
 { }
+
+void
+Widget::childResized(Widget * /*child*/)
+{ }
@@ -19,10 +19,10 @@
 #ifndef LIBCURSED__GUTS__WIDGET_HPP__
 #define LIBCURSED__GUTS__WIDGET_HPP__
 
-namespace cursed { namespace guts {
+#include "Pos.hpp"
+#include "Size.hpp"
 
-struct Pos;
-struct Size;
+namespace cursed { namespace guts {
 
 // Base class for all widgets in the library.
 class Widget
@@ -36,8 +36,9 @@ protected:
     ~Widget() = default;
 
 public:
-    // Performs position and size update.  The default just calls
-    // `placed(newPos, newSize)`.
+    // Performs position and size update.  The default calls
+    // `placed(newPos, newSize)` unless neither position and size nor size
+    // policies of children have changed since the last call.
     virtual void place(Pos newPos, Size newSize);
     // Updates state of this widget to be published on the screen.
     virtual void draw() = 0;
@@ -46,6 +47,15 @@ public:
     // fixed-size widgets.
     void setFixedSize(int colsNum, int linesNum);
 
+    // Checks whether the widget was placed with zero area.  Such widgets are
+    // not drawn by containers.
+    bool isHidden() const
+    { return hidden; }
+
+    // Sets container of this widget, which gets notified when desired size of
+    // the widget changes.  Meant to be called by containers.
+    void setParent(Widget *newParent);
+
     // Retrieves vertical size policy.
     // Positive number or zero means exactly that much.
     // Negative number means at least that much in magnitude.
@@ -55,6 +65,12 @@ public:
     // Negative number means at least that much in magnitude.
     int getDesiredWidth();
 
+protected:
+    // Drops cached size policy of this widget and of its containers and makes
+    // them lay out their contents on the next `place()`.  Should be called
+    // when results of `desired*()` change.
+    void invalidateSize();
+
 private:
     // Retrieves vertical size policy.
     // Positive number or zero means exactly that much.
@@ -67,11 +83,26 @@ private:
 
     // Notifies widget of new position and size.
     virtual void placed(Pos newPos, Size newSize);
+    // Notifies container that size policy of its `child` (direct one) or of
+    // something inside of it might have changed.
+    virtual void childResized(Widget *child);
 
 private:
     bool hasFixedSize; // Whether size is fixed.
     int cols;          // Columns for the fixed size.
     int lines;         // Lines for the fixed size.
+    Widget *parent;    // Container of this widget or `nullptr`.
+    // Results of `desired*()` are cached until `invalidateSize()` is called.
+    // Size policy of a container is cached only if size policies of its
+    // children are, so invalidation stops at the first uncached container.
+    bool heightCached; // Whether `cachedHeight` is valid.
+    bool widthCached;  // Whether `cachedWidth` is valid.
+    int cachedHeight;  // Cached result of `desiredHeight()`.
+    int cachedWidth;   // Cached result of `desiredWidth()`.
+    bool placeValid;   // Whether placement doesn't need to be redone.
+    bool hidden;       // Whether the last placement had zero area.
+    Pos lastPos;       // Position of the last placement.
+    Size lastSize;     // Size of the last placement.
 };
 
 } }
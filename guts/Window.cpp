@@ -20,12 +20,21 @@
 
 #include <curses.h>
 
+#include <cstddef>
+#include <cwchar>
+
+#include <algorithm>
 #include <stdexcept>
+#include <string>
 #include <utility>
+#include <vector>
 
 #include "../ColorTree.hpp"
+#include "../utils.hpp"
+#include "Cell.hpp"
 #include "ColorManager.hpp"
 #include "Pos.hpp"
+#include "RowCache.hpp"
 #include "Size.hpp"
 
 using namespace cursed::guts;
@@ -67,8 +76,85 @@ struct Rendition
     }
 };
 
+// Tracks how much of text can still be displayed.
+struct Clip
+{
+    int cols;      // Width of the window.
+    int cells;     // Number of cells left in current row.
+    int rows;      // Number of rows below current one.
+    int skip;      // Number of leading cells to hide.
+    bool hiding;   // Whether previous character was hidden.
+    int pad;       // Number of cells of partially hidden character.
+
+    // Checks whether nothing else can be displayed.
+    bool isFull() const
+    {
+        return (cells <= 0 && rows == 0);
+    }
+
+    // Accounts for a character at the start of text.  Returns `true` if the
+    // character is hidden.
+    bool hide(wchar_t wc)
+    {
+        const int width = getWidth(wc);
+        if (skip <= 0) {
+            // Zero-width characters that follow hidden one are hidden too.
+            hiding = (hiding && width == 0 && wc != L'\n');
+            return hiding;
+        }
+
+        skip -= width;
+        hiding = true;
+        if (skip < 0) {
+            // Visible part of a wide character is replaced with spaces.
+            pad = -skip;
+            cells -= pad;
+            skip = 0;
+        }
+        return true;
+    }
+
+    // Accounts for a character.  Returns `false` if it can't be displayed.
+    // Width of text is never overestimated, so output is never cut too early.
+    bool add(wchar_t wc)
+    {
+        if (wc == L'\n') {
+            if (rows == 0) {
+                return false;
+            }
+            --rows;
+            cells = cols;
+            return true;
+        }
+
+        const int width = getWidth(wc);
+
+        // Zero-width characters that follow the last one are kept.
+        if (cells <= 0 && width > 0) {
+            return false;
+        }
+
+        cells -= width;
+        return true;
+    }
+
+    // Retrieves number of cells a character occupies at least.  Control
+    // characters (like tabulation) can occupy any number of cells depending
+    // on cursor position, so they are counted as zero-width.
+    static int getWidth(wchar_t wc)
+    {
+        const int width = wcwidth(wc);
+        return (width < 0 ? 0 : width);
+    }
+};
+
 }
 
+static bool putNarrow(WINDOW *win, const std::string &text, Clip &clip);
+static bool putWide(WINDOW *win, const std::wstring &text, Clip &clip);
+static bool putUtf8(WINDOW *win, const std::string &text, Clip &clip);
+static void putPad(WINDOW *win, Clip &clip);
+
 // A shorthand for converting `void *` to `WINDOW *`.
 static inline WINDOW *
 w(void *ptr)
@@ -76,7 +162,7 @@ w(void *ptr)
     return static_cast<WINDOW *>(ptr);
 }
 
-Window::Window() : hidden(false)
+Window::Window() : hidden(false), lines(1), cols(1)
 {
     ptr = newwin(1, 1, 0, 0);
     if (ptr == nullptr) {
@@ -93,10 +179,20 @@ void
 Window::place(Pos newPos, Size newSize)
 {
     hidden = (newSize.lines == 0 || newSize.cols == 0);
+    lines = newSize.lines;
+    cols = newSize.cols;
     if (hidden) {
         return;
     }
 
+    int y, x, h, wd;
+    getbegyx(w(ptr), y, x);
+    getmaxyx(w(ptr), h, wd);
+    if (y == newPos.y && x == newPos.x &&
+        h == newSize.lines && wd == newSize.cols) {
+        return;
+    }
+
     // Move fails if window would be only partially visible at destination, so
     // resizing should be performed first.
     if (wresize(w(ptr), newSize.lines, newSize.cols) != OK) {
@@ -124,13 +220,69 @@ Window::erase()
 }
 
 void
-Window::print(const ColorTree &colored)
+Window::print(const ColorTree &colored, const Format &base, int skip,
+              bool singleRow)
 {
-    colored.visit([&](const std::wstring &text, const Format &format) {
+    const bool utf8Locale = isUtf8Locale();
+    Clip clip = { cols, 0, 0, skip, false, 0 };
+    getSpaceLeft(clip.cells, clip.rows, singleRow);
+
+    colored.visitRawWhile([&](const LeafText &text, const Format &format) {
         Rendition rendition(format);
         wattr_set(w(ptr), rendition.attrs, rendition.pair, nullptr);
-        wprintw(w(ptr), "%ls", text.c_str());
-    });
+
+        if (!text.isUtf8()) {
+            return putWide(w(ptr), text.getWide(), clip);
+        }
+        if (utf8Locale) {
+            // No need to convert, curses accepts text in this encoding.
+            return putNarrow(w(ptr), text.getUtf8(), clip);
+        }
+        return putUtf8(w(ptr), text.getUtf8(), clip);
+    }, base);
+}
+
+void
+Window::print(const Cell &cell, const Format &base, int skip, bool singleRow)
+{
+    if (!cell.isPlain()) {
+        print(cell.getTree(), base, skip, singleRow);
+        return;
+    }
+
+    Rendition rendition(base);
+    wattr_set(w(ptr), rendition.attrs, rendition.pair, nullptr);
+    Clip clip = { cols, 0, 0, skip, false, 0 };
+    getSpaceLeft(clip.cells, clip.rows, singleRow);
+    if (isUtf8Locale()) {
+        // No need to convert, curses accepts text in this encoding.
+        putNarrow(w(ptr), cell.getPlain(), clip);
+    } else {
+        putUtf8(w(ptr), cell.getPlain(), clip);
+    }
+}
+
+void
+Window::print(const std::vector<Run> &runs, int skip, bool singleRow)
+{
+    Clip clip = { cols, 0, 0, skip, false, 0 };
+    getSpaceLeft(clip.cells, clip.rows, singleRow);
+    for (const Run &run : runs) {
+        Rendition rendition(run.format);
+        wattr_set(w(ptr), rendition.attrs, rendition.pair, nullptr);
+        if (!putWide(w(ptr), run.text, clip)) {
+            break;
+        }
+    }
+}
+
+void
+Window::getSpaceLeft(int &cells, int &rows, bool singleRow)
+{
+    int y, x;
+    getyx(w(ptr), y, x);
+    cells = cols - x;
+    rows = (singleRow ? 0 : lines - y - 1);
 }
 
 bool
@@ -177,3 +329,95 @@ void
 {
     wclrtoeol(w(win.raw()));
 }
+
+// Prints part of a string in multibyte encoding of current locale that's not
+// hidden and fits on the screen.  Returns `false` if nothing else fits.
+static bool
+putNarrow(WINDOW *win, const std::string &text, Clip &clip)
+{
+    std::mbstate_t state = {};
+    std::size_t from = 0U;
+    std::size_t i = 0U;
+    bool fits = true;
+    while (i < text.size()) {
+        wchar_t wc;
+        std::size_t n = std::mbrtowc(&wc, &text[i], text.size() - i, &state);
+        if (n == static_cast<std::size_t>(-1) ||
+            n == static_cast<std::size_t>(-2)) {
+            // Invalid byte might not be displayed at all.
+            state = {};
+            n = 1U;
+            wc = L'\0';
+        } else if (n == 0U) {
+            n = 1U;
+        }
+
+        if (from == i && clip.hide(wc)) {
+            from += n;
+        } else if (!clip.add(wc)) {
+            fits = false;
+            break;
+        }
+        i += n;
+    }
+
+    putPad(win, clip);
+    waddnstr(win, text.c_str() + from, i - from);
+    return (fits && !clip.isFull());
+}
+
+// Prints part of a wide string that's not hidden and fits on the screen.
+// Returns `false` if nothing else fits.
+static bool
+putWide(WINDOW *win, const std::wstring &text, Clip &clip)
+{
+    std::size_t from = 0U;
+    while (from < text.size() && clip.hide(text[from])) {
+        ++from;
+    }
+
+    std::size_t i = from;
+    while (i < text.size() && clip.add(text[i])) {
+        ++i;
+    }
+
+    putPad(win, clip);
+    waddnwstr(win, text.c_str() + from, i - from);
+    return (i == text.size() && !clip.isFull());
+}
+
+// Prints part of a UTF-8 string that's not hidden and fits on the screen.
+// Text is converted piece by piece, so the part that isn't displayed isn't
+// converted.  Returns `false` if nothing else fits.
+static bool
+putUtf8(WINDOW *win, const std::string &text, Clip &clip)
+{
+    // Number of bytes converted at once.
+    const std::size_t PieceSize = 256U;
+
+    std::size_t from = 0U;
+    while (from < text.size()) {
+        // Pieces end at boundaries of characters.
+        std::size_t to = std::min(text.size(), from + PieceSize);
+        while (to < text.size() &&
+               (static_cast<unsigned char>(text[to]) & 0xc0) == 0x80) {
+            ++to;
+        }
+
+        const std::string piece = text.substr(from, to - from);
+        if (!putWide(win, cursed::fromUtf8(piece), clip)) {
+            return false;
+        }
+        from = to;
+    }
+    return !clip.isFull();
+}
+
+// Prints spaces in place of visible part of partially hidden character.
+static void
+putPad(WINDOW *win, Clip &clip)
+{
+    for (; clip.pad > 0; --clip.pad) {
+        waddch(win, ' ');
+    }
+}
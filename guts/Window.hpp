@@ -21,11 +21,15 @@
 
 #include <cwctype>
 
+#include <vector>
+
 #include "../ColorTree.hpp"
 
 namespace cursed { namespace guts {
 
+class Cell;
 struct Pos;
+struct Run;
 struct Size;
 
 // Manages window resource.
@@ -58,15 +62,38 @@ public:
     void erase();
 
     // Prints colored text on the window at the current cursor position.
-    void print(const ColorTree &colored);
+    // `base` is applied to the whole text as if it wrapped the tree.  Output is
+    // clipped at the right edge of the window.  The first `skip` cells of text
+    // are hidden.  With `singleRow` set, output stops at the end of the
+    // current row and the rest of the text isn't looked at.
+    void print(const ColorTree &colored, const Format &base = {},
+               int skip = 0, bool singleRow = false);
+    // Prints contents of a cell on the window at the current cursor position.
+    // `base` is applied to the whole text as if it wrapped the cell.  Output is
+    // clipped at the right edge of the window.  The first `skip` cells of text
+    // are hidden.  `singleRow` has the same meaning as above.
+    void print(const Cell &cell, const Format &base = {}, int skip = 0,
+               bool singleRow = false);
+    // Prints runs of text on the window at the current cursor position.
+    // Output is clipped at the right edge of the window.  The first `skip`
+    // cells of text are hidden.  `singleRow` has the same meaning as above.
+    void print(const std::vector<Run> &runs, int skip = 0,
+               bool singleRow = false);
 
     // Checks whether this window is hidden and shouldn't be drawn.
     bool isHidden() const;
 
+private:
+    // Computes number of cells from the cursor to the end of its row and
+    // number of rows below the cursor (zero for `singleRow`).
+    void getSpaceLeft(int &cells, int &rows, bool singleRow);
+
 private:
     void *ptr;   // Opaque pointer to the resource.
     Format bg;   // Background/default format of the window.
     bool hidden; // Whether it's a hidden (resized to zero area).
+    int lines;   // Height of the window.
+    int cols;    // Width of the window.
 };
 
 // Sets a window flag that defines whether functional keys are recognized as
@@ -0,0 +1,149 @@
+// libcursed -- C++ classes for dealing with curses
+// Copyright (C) 2022 xaizek <xaizek@posteo.net>
+//
+// This file is part of libcursed.
+//
+// libcursed is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// libcursed is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with libcursed.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "WrapCache.hpp"
+
+#include <cwchar>
+
+#include <list>
+#include <utility>
+#include <vector>
+
+#include "RowCache.hpp"
+
+using namespace cursed;
+using namespace cursed::guts;
+
+std::vector<int>
+guts::findWrapPoints(const std::vector<Run> &runs, int width)
+{
+    std::vector<int> points;
+
+    int offset = 0;
+    int col = 0;
+    for (const Run &run : runs) {
+        for (wchar_t c : run.text) {
+            // Control characters are displayed by curses in a visible form.
+            int w = wcwidth(c);
+            if (w < 0) {
+                w = 1;
+            }
+
+            if (col + w > width && col != 0) {
+                points.push_back(offset);
+                col = 0;
+            }
+            col += w;
+            ++offset;
+        }
+    }
+
+    return points;
+}
+
+WrapCache::WrapCache() : capacity(1), width(0), nWrapped(0), nRows(0)
+{ }
+
+void
+WrapCache::clear()
+{
+    entries.clear();
+    index.clear();
+}
+
+void
+WrapCache::invalidate(int line)
+{
+    auto it = index.find(line);
+    if (it != index.end()) {
+        entries.erase(it->second);
+        index.erase(it);
+    }
+}
+
+void
+WrapCache::shift(int from, int count, int n)
+{
+    index.clear();
+    for (auto it = entries.begin(); it != entries.end(); ) {
+        if (it->line >= from + count) {
+            it->line += n - count;
+        } else if (it->line >= from) {
+            it = entries.erase(it);
+            continue;
+        }
+        index.emplace(it->line, it);
+        ++it;
+    }
+}
+
+void
+WrapCache::resize(int size)
+{
+    clear();
+    capacity = (size < 1 ? 1 : size);
+}
+
+void
+WrapCache::setWidth(int newWidth)
+{
+    if (newWidth != width) {
+        width = newWidth;
+        nWrapped = 0;
+        nRows = 0;
+        clear();
+    }
+}
+
+const std::vector<int> *
+WrapCache::find(int line)
+{
+    auto it = index.find(line);
+    if (it == index.end()) {
+        return nullptr;
+    }
+
+    entries.splice(entries.begin(), entries, it->second);
+    return &it->second->points;
+}
+
+const std::vector<int> &
+WrapCache::store(int line, std::vector<int> points)
+{
+    ++nWrapped;
+    nRows += 1 + points.size();
+
+    invalidate(line);
+    if (static_cast<int>(entries.size()) >= capacity) {
+        index.erase(entries.back().line);
+        entries.pop_back();
+    }
+
+    entries.push_front({ line, std::move(points) });
+    index.emplace(line, entries.begin());
+    return entries.front().points;
+}
+
+int
+WrapCache::estimateRows(int nLines) const
+{
+    if (nWrapped == 0) {
+        return nLines;
+    }
+    return (nLines*nRows + nWrapped/2)/nWrapped;
+}
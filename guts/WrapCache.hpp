@@ -0,0 +1,91 @@
+// libcursed -- C++ classes for dealing with curses
+// Copyright (C) 2022 xaizek <xaizek@posteo.net>
+//
+// This file is part of libcursed.
+//
+// libcursed is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// libcursed is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with libcursed.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef LIBCURSED__GUTS__WRAPCACHE_HPP__
+#define LIBCURSED__GUTS__WRAPCACHE_HPP__
+
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+namespace cursed { namespace guts {
+
+struct Run;
+
+// Computes offsets in characters at which continuation rows of a line start
+// when the line is wrapped at `width` screen columns.  Accounts for characters
+// that take up more than one column.
+std::vector<int> findWrapPoints(const std::vector<Run> &runs, int width);
+
+// Caches wrap points of lines for a single width.  Only a limited number of
+// lines is kept, which is enough for lines around the viewport.  The least
+// recently used line is dropped to make room for a new one.
+class WrapCache
+{
+public:
+    // Constructs a cache for a single line.
+    WrapCache();
+
+public:
+    // Drops all cached lines.
+    void clear();
+    // Drops cached version of a single line.
+    void invalidate(int line);
+    // Updates indexes of lines after `count` lines starting at `from` were
+    // replaced with `n` lines dropping the replaced ones.
+    void shift(int from, int count, int n);
+    // Sets how many lines can be cached at once (dropping all of them).  At
+    // least one line is always kept.
+    void resize(int size);
+    // Sets width of wrapping dropping all lines if it has changed.
+    void setWidth(int newWidth);
+    // Retrieves width of wrapping.
+    int getWidth() const
+    { return width; }
+
+    // Retrieves wrap points of a line or `nullptr` if there are none.  Marks
+    // the line as recently used.
+    const std::vector<int> * find(int line);
+    // Remembers wrap points of a line.  Returns reference to stored points.
+    const std::vector<int> & store(int line, std::vector<int> points);
+
+    // Estimates number of screen rows that `nLines` lines take up using
+    // average height of lines that were wrapped.
+    int estimateRows(int nLines) const;
+
+private:
+    // Single cached line.
+    struct Entry
+    {
+        int line;                // Index of the line.
+        std::vector<int> points; // Wrap points of the line.
+    };
+
+private:
+    std::list<Entry> entries; // Cached lines, most recently used first.
+    // Entries by index of their line.
+    std::unordered_map<int, std::list<Entry>::iterator> index;
+    int capacity;             // Maximum number of entries.
+    int width;                // Width at which lines are wrapped.
+    long long nWrapped;       // Number of lines wrapped at current width.
+    long long nRows;          // Number of rows taken by `nWrapped` lines.
+};
+
+} }
+
+#endif // LIBCURSED__GUTS__WRAPCACHE_HPP__
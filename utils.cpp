@@ -36,6 +36,109 @@ cursed::toWide(const std::string &s)
     return result;
 }
 
+std::wstring
+cursed::fromUtf8(const std::string &s)
+{
+    std::wstring result;
+    result.reserve(s.length());
+
+    const std::size_t len = s.length();
+    std::size_t i = 0U;
+    while (i < len) {
+        const unsigned char c = s[i];
+        if (c < 0x80) {
+            result += static_cast<wchar_t>(c);
+            ++i;
+            continue;
+        }
+
+        int extra;
+        char32_t cp;
+        if ((c & 0xe0) == 0xc0) {
+            extra = 1;
+            cp = c & 0x1f;
+        } else if ((c & 0xf0) == 0xe0) {
+            extra = 2;
+            cp = c & 0x0f;
+        } else if ((c & 0xf8) == 0xf0) {
+            extra = 3;
+            cp = c & 0x07;
+        } else {
+            result += L'\xfffd';
+            ++i;
+            continue;
+        }
+
+        int n = 0;
+        while (n < extra && i + 1U + n < len &&
+               (static_cast<unsigned char>(s[i + 1U + n]) & 0xc0) == 0x80) {
+            cp = (cp << 6) | (s[i + 1U + n] & 0x3f);
+            ++n;
+        }
+        if (n != extra || cp > 0x10ffff) {
+            result += L'\xfffd';
+            i += 1U + n;
+            continue;
+        }
+        i += 1U + n;
+
+        if (sizeof(wchar_t) == 2 && cp >= 0x10000) {
+            cp -= 0x10000;
+            result += static_cast<wchar_t>(0xd800 + (cp >> 10));
+            result += static_cast<wchar_t>(0xdc00 + (cp & 0x3ff));
+        } else {
+            result += static_cast<wchar_t>(cp);
+        }
+    }
+
+    return result;
+}
+
+std::string
+cursed::toUtf8(const std::wstring &ws)
+{
+    std::string result;
+    result.reserve(ws.length());
+
+    for (std::size_t i = 0U; i < ws.length(); ++i) {
+        char32_t cp = static_cast<char32_t>(ws[i]);
+        if (sizeof(wchar_t) == 2 && cp >= 0xd800 && cp < 0xdc00 &&
+            i + 1U < ws.length()) {
+            cp = 0x10000 + ((cp - 0xd800) << 10) + (ws[++i] - 0xdc00);
+        }
+
+        if (cp < 0x80) {
+            result += static_cast<char>(cp);
+        } else if (cp < 0x800) {
+            result += static_cast<char>(0xc0 | (cp >> 6));
+            result += static_cast<char>(0x80 | (cp & 0x3f));
+        } else if (cp < 0x10000) {
+            result += static_cast<char>(0xe0 | (cp >> 12));
+            result += static_cast<char>(0x80 | ((cp >> 6) & 0x3f));
+            result += static_cast<char>(0x80 | (cp & 0x3f));
+        } else {
+            result += static_cast<char>(0xf0 | (cp >> 18));
+            result += static_cast<char>(0x80 | ((cp >> 12) & 0x3f));
+            result += static_cast<char>(0x80 | ((cp >> 6) & 0x3f));
+            result += static_cast<char>(0x80 | (cp & 0x3f));
+        }
+    }
+
+    return result;
+}
+
+int
+cursed::countUtf8Chars(const char *begin, const char *end)
+{
+    int count = 0;
+    for (const char *p = begin; p != end; ++p) {
+        if ((static_cast<unsigned char>(*p) & 0xc0) != 0x80) {
+            ++count;
+        }
+    }
+    return count;
+}
+
 std::string
 cursed::toNarrow(const std::wstring &ws)
 {
@@ -31,6 +31,17 @@ std::wstring toWide(const std::string &s);
 // error.
 std::string toNarrow(const std::wstring &ws);
 
+// Decodes UTF-8 regardless of current locale.  Invalid sequences are replaced
+// with U+FFFD.
+std::wstring fromUtf8(const std::string &s);
+
+// Encodes string in UTF-8 regardless of current locale.
+std::string toUtf8(const std::wstring &ws);
+
+// Counts characters in UTF-8 byte range [begin; end), which are all bytes
+// except for continuation bytes.
+int countUtf8Chars(const char *begin, const char *end);
+
 }
 
 #endif // LIBCURSED__UTILS_HPP__
@@ -6,4 +6,5 @@ target("cursed")
     add_files("*.cpp")
     add_files("guts/*.cpp")
     add_packages("ncursesw")
+    add_syslinks("pthread")
     on_install(function() end)